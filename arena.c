@@ -0,0 +1,105 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the data of a page starts after its header
+#define ARENA_HEADER_SIZE ((sizeof(ArenaPage) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+size_t Arena_align(const size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+unsigned char *Arena_page_data(ArenaPage *page)
+{
+    return (unsigned char *)page + ARENA_HEADER_SIZE;
+}
+
+void *Arena_alloc(Arena *self, const size_t size)
+{
+    const size_t aligned = Arena_align(size);
+
+    // use the current page, then the recycled ones
+    while (self->current != NULL)
+    {
+        ArenaPage *page = self->current;
+        if (page->size - page->used >= aligned)
+        {
+            void *memory = Arena_page_data(page) + page->used;
+            page->used += aligned;
+            return memory;
+        }
+        if (page->next == NULL)
+            break;
+        self->current = page->next;
+        self->current->used = 0;
+    }
+
+    // add a new page after the current one
+    const size_t page_size = aligned > ARENA_PAGE_SIZE ? aligned : ARENA_PAGE_SIZE;
+    ArenaPage *page = malloc(ARENA_HEADER_SIZE + page_size);
+    if (page == NULL)
+        return NULL;
+    page->size = page_size;
+    page->used = aligned;
+    if (self->current == NULL)
+    {
+        page->next = self->first;
+        self->first = page;
+    }
+    else
+    {
+        page->next = self->current->next;
+        self->current->next = page;
+    }
+    self->current = page;
+    return Arena_page_data(page);
+}
+
+void *Arena_grow(Arena *self, void *memory, const size_t old_size, const size_t new_size)
+{
+    if (memory == NULL)
+        return Arena_alloc(self, new_size);
+    if (new_size <= old_size)
+        return memory;
+
+    // the last allocation of the current page can grow in place
+    ArenaPage *page = self->current;
+    if (page != NULL && (unsigned char *)memory + Arena_align(old_size) == Arena_page_data(page) + page->used)
+    {
+        const size_t extra = Arena_align(new_size) - Arena_align(old_size);
+        if (page->size - page->used >= extra)
+        {
+            page->used += extra;
+            return memory;
+        }
+    }
+
+    void *grown = Arena_alloc(self, new_size);
+    if (grown == NULL)
+        return NULL;
+    memcpy(grown, memory, old_size);
+    return grown;
+}
+
+void Arena_reset(Arena *self)
+{
+    // the following pages are reset when they become the current one
+    self->current = self->first;
+    if (self->current != NULL)
+        self->current->used = 0;
+}
+
+void Arena_destroy(Arena *self)
+{
+    ArenaPage *page = self->first;
+    while (page != NULL)
+    {
+        ArenaPage *next = page->next;
+        free(page);
+        page = next;
+    }
+    self->first = NULL;
+    self->current = NULL;
+}
@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+#define ARENA_PAGE_SIZE (1 << 20)
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaPage {
+    struct ArenaPage *next;
+    size_t size;
+    size_t used;
+} ArenaPage;
+
+// Bump allocator made of large pages, kept from one reset to the next
+typedef struct Arena {
+    ArenaPage *first;
+    ArenaPage *current;
+} Arena;
+
+/**
+ * @brief Allocate memory from the arena
+ * @param self The arena
+ * @param size The size to allocate
+ * @return The memory (aligned on ARENA_ALIGNMENT), NULL on failure
+ */
+void *Arena_alloc(Arena *self, const size_t size);
+
+/**
+ * @brief Grow an allocation of the arena
+ * @param self The arena
+ * @param memory The memory to grow, or NULL
+ * @param old_size The current size of the memory
+ * @param new_size The new size of the memory
+ * @return The grown memory with the old content, NULL on failure (the old memory is kept)
+ * @note The last allocation of a page grows in place, others are copied
+ */
+void *Arena_grow(Arena *self, void *memory, const size_t old_size, const size_t new_size);
+
+/**
+ * @brief Release every allocation, keeping the pages for the next ones
+ * @param self The arena
+ * @note This is O(1), the pages are recycled lazily
+ */
+void Arena_reset(Arena *self);
+
+/**
+ * @brief Free the pages of the arena
+ * @param self The arena
+ */
+void Arena_destroy(Arena *self);
+
+#endif // ARENA_H
@@ -0,0 +1,103 @@
+#include "bitboard.h"
+
+#include <string.h>
+
+// Kernels of the size class of BITS cells, with the rows and the columns in words of TYPE
+#define BITBOARD_DEFINE_KERNELS(BITS, TYPE)                                                                           \
+    bool Bitboard##BITS##_get(const Bitboard *self, const int x, const int y)                                      \
+    {                                                                                                              \
+        return self->words##BITS[y] >> x & 1;                                                                      \
+    }                                                                                                              \
+                                                                                                                   \
+    void Bitboard##BITS##_set(Bitboard *self, const int x, const int y, const bool occupied)                      \
+    {                                                                                                              \
+        TYPE *rows = self->words##BITS;                                                                            \
+        TYPE *columns = rows + BITS;                                                                               \
+        if (occupied)                                                                                              \
+        {                                                                                                          \
+            rows[y] |= (TYPE)((TYPE)1 << x);                                                                       \
+            columns[x] |= (TYPE)((TYPE)1 << y);                                                                    \
+        }                                                                                                          \
+        else                                                                                                       \
+        {                                                                                                          \
+            rows[y] &= (TYPE)~((TYPE)1 << x);                                                                      \
+            columns[x] &= (TYPE)~((TYPE)1 << y);                                                                   \
+        }                                                                                                          \
+    }                                                                                                              \
+                                                                                                                   \
+    int Bitboard##BITS##_raycast(const Bitboard *self, const int x, const int y, const int dx, const int dy)      \
+    {                                                                                                              \
+        /* the row for a horizontal ray, the column for a vertical one */                                          \
+        const TYPE *rows = self->words##BITS;                                                                      \
+        const unsigned long long line = dx != 0 ? rows[y] : rows[BITS + x];                                        \
+        const int at = dx != 0 ? x : y;                                                                            \
+        const int step = dx != 0 ? dx : dy;                                                                        \
+        if (step > 0)                                                                                              \
+        {                                                                                                          \
+            const unsigned long long ahead = line >> at;                                                           \
+            return ahead != 0 ? __builtin_ctzll(ahead) : -1;                                                       \
+        }                                                                                                          \
+        if (step < 0)                                                                                              \
+        {                                                                                                          \
+            const unsigned long long behind = line << (63 - at);                                                   \
+            return behind != 0 ? __builtin_clzll(behind) : -1;                                                     \
+        }                                                                                                          \
+        return line >> at & 1 ? 0 : -1;                                                                            \
+    }                                                                                                              \
+                                                                                                                   \
+    int Bitboard##BITS##_free_neighbors(const Bitboard *self, const int x, const int y)                           \
+    {                                                                                                              \
+        /* the free cells of the row and of the column next to the cell, in the game area */                     \
+        const TYPE *rows = self->words##BITS;                                                                      \
+        const unsigned long long row = ~(unsigned long long)rows[y];                                               \
+        const unsigned long long column = ~(unsigned long long)rows[BITS + x];                                     \
+        return (int)((y > 0 ? column >> (y - 1) & 1 : 0)                                                           \
+                     | (y + 1 < self->height ? column >> (y + 1) & 1 : 0) << 1                                     \
+                     | (x > 0 ? row >> (x - 1) & 1 : 0) << 2                                                       \
+                     | (x + 1 < self->width ? row >> (x + 1) & 1 : 0) << 3);                                       \
+    }                                                                                                              \
+                                                                                                                   \
+    const BitboardKernels BITBOARD_KERNELS_##BITS = {                                                              \
+        BITS, Bitboard##BITS##_get, Bitboard##BITS##_set, Bitboard##BITS##_raycast, Bitboard##BITS##_free_neighbors \
+    };
+
+BITBOARD_DEFINE_KERNELS(8, unsigned char)
+BITBOARD_DEFINE_KERNELS(16, unsigned short)
+BITBOARD_DEFINE_KERNELS(32, unsigned int)
+BITBOARD_DEFINE_KERNELS(64, unsigned long long)
+
+bool Bitboard_init(Bitboard *self, const int width, const int height)
+{
+    // the smallest size class holding the game area
+    const int size = width > height ? width : height;
+    self->width = width;
+    self->height = height;
+    self->kernels = size <= 0 ? NULL
+                    : size <= 8 ? &BITBOARD_KERNELS_8
+                    : size <= 16 ? &BITBOARD_KERNELS_16
+                    : size <= 32 ? &BITBOARD_KERNELS_32
+                    : size <= 64 ? &BITBOARD_KERNELS_64
+                    : NULL;
+    memset(self->words64, 0, sizeof(self->words64));
+    return self->kernels != NULL;
+}
+
+bool Bitboard_get(const Bitboard *self, const int x, const int y)
+{
+    return self->kernels->get(self, x, y);
+}
+
+void Bitboard_set(Bitboard *self, const int x, const int y, const bool occupied)
+{
+    self->kernels->set(self, x, y, occupied);
+}
+
+int Bitboard_raycast(const Bitboard *self, const int x, const int y, const int dx, const int dy)
+{
+    return self->kernels->raycast(self, x, y, dx, dy);
+}
+
+int Bitboard_free_neighbors(const Bitboard *self, const int x, const int y)
+{
+    return self->kernels->free_neighbors(self, x, y);
+}
@@ -0,0 +1,82 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+#include <stdbool.h>
+
+#define BITBOARD_MAX_SIZE 64 // largest width and height of a bitboard
+
+typedef struct Bitboard Bitboard; // Forward declaration
+
+// Kernels of a size class, generated for each word size by BITBOARD_DEFINE_KERNELS
+typedef struct BitboardKernels {
+    int bits; // width and height of the size class
+    bool (*get)(const Bitboard *self, const int x, const int y);
+    void (*set)(Bitboard *self, const int x, const int y, const bool occupied);
+    int (*raycast)(const Bitboard *self, const int x, const int y, const int dx, const int dy);
+    int (*free_neighbors)(const Bitboard *self, const int x, const int y);
+} BitboardKernels;
+
+// Occupancy of a small game area, as a word per row and a word per column of the size of the area
+struct Bitboard {
+    int width;
+    int height;
+    const BitboardKernels *kernels; // NULL if the game area is too large
+
+    // The rows, then the columns, in the words of the size class
+    union {
+        unsigned char words8[2 * BITBOARD_MAX_SIZE];
+        unsigned short words16[2 * BITBOARD_MAX_SIZE];
+        unsigned int words32[2 * BITBOARD_MAX_SIZE];
+        unsigned long long words64[2 * BITBOARD_MAX_SIZE];
+    };
+};
+
+/**
+ * @brief Pick the size class of a game area and clear the cells
+ * @param self The bitboard
+ * @param width The width of the game area
+ * @param height The height of the game area
+ * @return True if the game area fits in a bitboard, false otherwise
+ */
+bool Bitboard_init(Bitboard *self, const int width, const int height);
+
+/**
+ * @brief Check if a cell is occupied
+ * @param self The bitboard
+ * @param x The x position, in the game area
+ * @param y The y position, in the game area
+ * @return True if the cell is occupied, false otherwise
+ */
+bool Bitboard_get(const Bitboard *self, const int x, const int y);
+
+/**
+ * @brief Set a cell as occupied or free
+ * @param self The bitboard
+ * @param x The x position, in the game area
+ * @param y The y position, in the game area
+ * @param occupied True if the cell is occupied, false otherwise
+ */
+void Bitboard_set(Bitboard *self, const int x, const int y, const bool occupied);
+
+/**
+ * @brief Find the first occupied cell from a cell in a direction
+ * @param self The bitboard
+ * @param x The x position, in the game area
+ * @param y The y position, in the game area
+ * @param dx The x step, -1, 0 or 1
+ * @param dy The y step, -1, 0 or 1
+ * @return The distance to the occupied cell, 0 for the cell itself, -1 if there is none
+ * @note A shift and a count of the trailing or leading zeros of the row or of the column
+ */
+int Bitboard_raycast(const Bitboard *self, const int x, const int y, const int dx, const int dy);
+
+/**
+ * @brief Get the free neighbors of a cell
+ * @param self The bitboard
+ * @param x The x position, in the game area
+ * @param y The y position, in the game area
+ * @return A mask with the bit d set when the neighbor in the direction d (up, down, left, right) is free and in the
+ * game area
+ */
+int Bitboard_free_neighbors(const Bitboard *self, const int x, const int y);
+
+#endif // BITBOARD_H
@@ -0,0 +1,302 @@
+#include "collision.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int Collision_floor_div2(const int value)
+{
+    return value >= 0 ? value / 2 : -((-value + 1) / 2);
+}
+
+bool Sweep_first_contact(const Sweep *self, const Sweep *other, const int other_reach, int *step, int *other_step)
+{
+    if (self->reach < 1 || other_reach < 1)
+        return false;
+
+    const bool horizontal = self->dx != 0;
+    const bool other_horizontal = other->dx != 0;
+
+    if (horizontal != other_horizontal)
+    {
+        // perpendicular: at most one common cell
+        const int cx = horizontal ? other->x : self->x;
+        const int cy = horizontal ? self->y : other->y;
+        const int t = horizontal ? (cx - self->x) * self->dx : (cy - self->y) * self->dy;
+        const int other_t = other_horizontal ? (cx - other->x) * other->dx : (cy - other->y) * other->dy;
+        if (t < 1 || t > self->reach || other_t < 1 || other_t > other_reach || other_t > t)
+            return false;
+        *step = t;
+        *other_step = other_t;
+        return true;
+    }
+
+    // parallel: they must be on the same line
+    if (horizontal ? self->y != other->y : self->x != other->x)
+        return false;
+
+    // positions along the line, and the cells both sweeps cover
+    const int a = horizontal ? self->x : self->y;
+    const int sigma = horizontal ? self->dx : self->dy;
+    const int other_a = horizontal ? other->x : other->y;
+    const int other_sigma = horizontal ? other->dx : other->dy;
+
+    const int first = a + sigma;
+    const int last = a + sigma * self->reach;
+    const int other_first = other_a + other_sigma;
+    const int other_last = other_a + other_sigma * other_reach;
+    int low = first < last ? first : last;
+    int high = first < last ? last : first;
+    low = low > (other_first < other_last ? other_first : other_last) ? low : (other_first < other_last ? other_first : other_last);
+    high = high < (other_first < other_last ? other_last : other_first) ? high : (other_first < other_last ? other_last : other_first);
+    if (low > high)
+        return false;
+
+    // keep the cells the other sweep entered first, and take the first one for this sweep
+    int u;
+    if (sigma == other_sigma)
+    {
+        // same direction: the other one must be ahead
+        if (sigma * other_a < sigma * a)
+            return false;
+        u = sigma > 0 ? low : high;
+    }
+    else if (sigma > 0)
+    {
+        // opposite directions: past the meeting point
+        const int meet = -Collision_floor_div2(-(a + other_a));
+        u = low > meet ? low : meet;
+        if (u > high)
+            return false;
+    }
+    else
+    {
+        const int meet = Collision_floor_div2(a + other_a);
+        u = high < meet ? high : meet;
+        if (u < low)
+            return false;
+    }
+
+    *step = sigma * (u - a);
+    *other_step = other_sigma * (u - other_a);
+    return true;
+}
+
+void SweepHash_get_tiles(const Sweep *sweep, int *min_tx, int *max_tx, int *min_ty, int *max_ty)
+{
+    // tiles from the first to the last cell of the sweep
+    const int x1 = sweep->x + sweep->dx;
+    const int y1 = sweep->y + sweep->dy;
+    const int x2 = sweep->x + sweep->dx * sweep->reach;
+    const int y2 = sweep->y + sweep->dy * sweep->reach;
+    *min_tx = (x1 < x2 ? x1 : x2) >> SWEEP_HASH_TILE_SHIFT;
+    *max_tx = (x1 < x2 ? x2 : x1) >> SWEEP_HASH_TILE_SHIFT;
+    *min_ty = (y1 < y2 ? y1 : y2) >> SWEEP_HASH_TILE_SHIFT;
+    *max_ty = (y1 < y2 ? y2 : y1) >> SWEEP_HASH_TILE_SHIFT;
+}
+
+int SweepHash_get_bucket(const SweepHash *self, const int tx, const int ty)
+{
+    const unsigned int hash = (unsigned int)tx * 73856093u ^ (unsigned int)ty * 19349663u;
+    return (int)(hash & (unsigned int)(self->num_buckets - 1));
+}
+
+void SweepHash_clear(SweepHash *self)
+{
+    self->num_sweeps = 0;
+    self->num_entries = 0;
+}
+
+bool SweepHash_add(SweepHash *self, const Sweep *sweep, const int id)
+{
+    if (self->num_sweeps == self->allocated_sweeps)
+    {
+        const int to_allocate = self->allocated_sweeps > 0 ? self->allocated_sweeps * 2 : SWEEP_HASH_MIN_BUCKETS;
+        Sweep *sweeps = realloc(self->sweeps, to_allocate * sizeof(Sweep));
+        if (sweeps == NULL)
+            return false;
+        self->sweeps = sweeps;
+        int *ids = realloc(self->ids, to_allocate * sizeof(int));
+        if (ids == NULL)
+            return false;
+        self->ids = ids;
+        int *candidates = realloc(self->candidates, to_allocate * sizeof(int));
+        if (candidates == NULL)
+            return false;
+        self->candidates = candidates;
+        int *stamps = realloc(self->stamps, to_allocate * sizeof(int));
+        if (stamps == NULL)
+            return false;
+        self->stamps = stamps;
+        self->allocated_sweeps = to_allocate;
+    }
+
+    self->sweeps[self->num_sweeps] = *sweep;
+    self->ids[self->num_sweeps] = id;
+    self->num_sweeps++;
+    return true;
+}
+
+bool SweepHash_build(SweepHash *self)
+{
+    // count the entries, one per tile crossed by each sweep
+    int num_entries = 0;
+    for (int i = 0; i < self->num_sweeps; i++)
+    {
+        int min_tx, max_tx, min_ty, max_ty;
+        SweepHash_get_tiles(&self->sweeps[i], &min_tx, &max_tx, &min_ty, &max_ty);
+        num_entries += (max_tx - min_tx + 1) * (max_ty - min_ty + 1);
+    }
+
+    // about two buckets per entry
+    int num_buckets = SWEEP_HASH_MIN_BUCKETS;
+    while (num_buckets < 2 * num_entries)
+        num_buckets *= 2;
+    if (num_buckets + 1 > self->allocated_buckets)
+    {
+        int *starts = realloc(self->starts, (num_buckets + 1) * sizeof(int));
+        if (starts == NULL)
+            return false;
+        self->starts = starts;
+        self->allocated_buckets = num_buckets + 1;
+    }
+    if (num_entries > self->allocated_entries)
+    {
+        int *entries = realloc(self->entries, num_entries * sizeof(int));
+        if (entries == NULL)
+            return false;
+        self->entries = entries;
+        self->allocated_entries = num_entries;
+    }
+    self->num_buckets = num_buckets;
+    self->num_entries = num_entries;
+
+    // counting sort of the entries by bucket
+    memset(self->starts, 0, (num_buckets + 1) * sizeof(int));
+    for (int i = 0; i < self->num_sweeps; i++)
+    {
+        int min_tx, max_tx, min_ty, max_ty;
+        SweepHash_get_tiles(&self->sweeps[i], &min_tx, &max_tx, &min_ty, &max_ty);
+        for (int ty = min_ty; ty <= max_ty; ty++)
+            for (int tx = min_tx; tx <= max_tx; tx++)
+                self->starts[SweepHash_get_bucket(self, tx, ty) + 1]++;
+    }
+    for (int b = 0; b < num_buckets; b++)
+        self->starts[b + 1] += self->starts[b];
+    for (int i = 0; i < self->num_sweeps; i++)
+    {
+        int min_tx, max_tx, min_ty, max_ty;
+        SweepHash_get_tiles(&self->sweeps[i], &min_tx, &max_tx, &min_ty, &max_ty);
+        for (int ty = min_ty; ty <= max_ty; ty++)
+            for (int tx = min_tx; tx <= max_tx; tx++)
+                self->entries[self->starts[SweepHash_get_bucket(self, tx, ty)]++] = i;
+    }
+    // the fill moved each start to the next bucket
+    for (int b = num_buckets; b > 0; b--)
+        self->starts[b] = self->starts[b - 1];
+    self->starts[0] = 0;
+
+    for (int i = 0; i < self->num_sweeps; i++)
+        self->stamps[i] = -1;
+    return true;
+}
+
+int SweepHash_query(SweepHash *self, const int index, const int **output)
+{
+    int min_tx, max_tx, min_ty, max_ty;
+    SweepHash_get_tiles(&self->sweeps[index], &min_tx, &max_tx, &min_ty, &max_ty);
+
+    int num_candidates = 0;
+    for (int ty = min_ty; ty <= max_ty; ty++)
+        for (int tx = min_tx; tx <= max_tx; tx++)
+        {
+            const int bucket = SweepHash_get_bucket(self, tx, ty);
+            for (int e = self->starts[bucket]; e < self->starts[bucket + 1]; e++)
+            {
+                const int other = self->entries[e];
+                if (other == index || self->stamps[other] == index)
+                    continue;
+                self->stamps[other] = index;
+                self->candidates[num_candidates++] = other;
+            }
+        }
+    *output = self->candidates;
+    return num_candidates;
+}
+
+void SweepHash_destroy(SweepHash *self)
+{
+    free(self->sweeps);
+    free(self->ids);
+    free(self->starts);
+    free(self->entries);
+    free(self->candidates);
+    free(self->stamps);
+    *self = (SweepHash){0};
+}
+
+bool Collision_before(const Collision *a, const Collision *b)
+{
+    if (a->step != b->step)
+        return a->step < b->step;
+    return a->victim < b->victim;
+}
+
+bool CollisionQueue_push(CollisionQueue *self, const Collision collision)
+{
+    if (self->num_collisions == self->allocated_collisions)
+    {
+        const int to_allocate = self->allocated_collisions > 0 ? self->allocated_collisions * 2 : 16;
+        Collision *tmp = realloc(self->collisions, to_allocate * sizeof(Collision));
+        if (tmp == NULL)
+            return false;
+        self->collisions = tmp;
+        self->allocated_collisions = to_allocate;
+    }
+
+    // sift up
+    int i = self->num_collisions++;
+    while (i > 0)
+    {
+        const int parent = (i - 1) / 2;
+        if (!Collision_before(&collision, &self->collisions[parent]))
+            break;
+        self->collisions[i] = self->collisions[parent];
+        i = parent;
+    }
+    self->collisions[i] = collision;
+    return true;
+}
+
+bool CollisionQueue_pop(CollisionQueue *self, Collision *output)
+{
+    if (self->num_collisions == 0)
+        return false;
+    *output = self->collisions[0];
+
+    // sift down the last one
+    const Collision last = self->collisions[--self->num_collisions];
+    int i = 0;
+    while (true)
+    {
+        int child = 2 * i + 1;
+        if (child >= self->num_collisions)
+            break;
+        if (child + 1 < self->num_collisions && Collision_before(&self->collisions[child + 1], &self->collisions[child]))
+            child++;
+        if (!Collision_before(&self->collisions[child], &last))
+            break;
+        self->collisions[i] = self->collisions[child];
+        i = child;
+    }
+    if (self->num_collisions > 0)
+        self->collisions[i] = last;
+    return true;
+}
+
+void CollisionQueue_destroy(CollisionQueue *self)
+{
+    free(self->collisions);
+    self->collisions = NULL;
+    self->num_collisions = 0;
+    self->allocated_collisions = 0;
+}
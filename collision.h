@@ -0,0 +1,125 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+#include <stdbool.h>
+
+// Straight move of a player during one tick: the cells (x, y) + step * (dx, dy), for step in [1, reach]
+typedef struct Sweep {
+    int x;
+    int y;
+    int dx;
+    int dy;
+    int reach;
+} Sweep;
+
+// A player entering, at step, a cell another player entered at other_step (other_step <= step)
+typedef struct Collision {
+    int step;
+    int victim;
+    int other;
+    int other_step;
+} Collision;
+
+// Min-heap of collisions ordered by step
+typedef struct CollisionQueue {
+    Collision *collisions;
+    int num_collisions;
+    int allocated_collisions;
+} CollisionQueue;
+
+#define SWEEP_HASH_TILE_SHIFT 3 // sweeps are hashed by tiles of 8x8 cells
+#define SWEEP_HASH_MIN_BUCKETS 64
+
+// Spatial hash of the sweeps of an update, to only test the sweeps sharing a tile
+typedef struct SweepHash {
+    // Sweeps added since the last clear, with the index of their player
+    Sweep *sweeps;
+    int *ids;
+    int num_sweeps;
+    int allocated_sweeps;
+
+    // Sweeps of each bucket: bucket b holds entries[starts[b]] to entries[starts[b + 1] - 1]
+    int *starts;
+    int num_buckets;
+    int allocated_buckets;
+    int *entries;
+    int num_entries;
+    int allocated_entries;
+
+    // Candidates of the last query, each sweep reported once
+    int *candidates;
+    int *stamps;
+} SweepHash;
+
+/**
+ * @brief Find the first cell of a sweep that another sweep entered before or at the same step
+ * @param self The sweep
+ * @param other The other sweep
+ * @param other_reach The last step reached by the other sweep
+ * @param step The output step of the sweep
+ * @param other_step The output step of the other sweep
+ * @return True if there is such a cell, false otherwise
+ * @note Sweeps are axis-aligned, so this is O(1) whatever their length
+ */
+bool Sweep_first_contact(const Sweep *self, const Sweep *other, const int other_reach, int *step, int *other_step);
+
+/**
+ * @brief Remove all the sweeps, keeping the memory
+ * @param self The hash
+ */
+void SweepHash_clear(SweepHash *self);
+
+/**
+ * @brief Add a sweep
+ * @param self The hash
+ * @param sweep The sweep
+ * @param id The index of the player of the sweep
+ * @return True if the sweep was added, false otherwise
+ */
+bool SweepHash_add(SweepHash *self, const Sweep *sweep, const int id);
+
+/**
+ * @brief Bucket the sweeps added since the last clear by the tiles they cross
+ * @param self The hash
+ * @return True if the hash was built, false otherwise
+ */
+bool SweepHash_build(SweepHash *self);
+
+/**
+ * @brief Get the sweeps sharing a tile with a sweep
+ * @param self The hash
+ * @param index The index of the sweep in the hash
+ * @param output The output candidates (indices in the hash), valid until the next query
+ * @return The number of candidates
+ * @note The hash must be built
+ */
+int SweepHash_query(SweepHash *self, const int index, const int **output);
+
+/**
+ * @brief Destroy the hash
+ * @param self The hash
+ */
+void SweepHash_destroy(SweepHash *self);
+
+/**
+ * @brief Push a collision
+ * @param self The queue
+ * @param collision The collision
+ * @return True if the collision was pushed, false otherwise
+ */
+bool CollisionQueue_push(CollisionQueue *self, const Collision collision);
+
+/**
+ * @brief Pop the collision with the smallest step
+ * @param self The queue
+ * @param output The output collision
+ * @return True if a collision was popped, false if the queue is empty
+ */
+bool CollisionQueue_pop(CollisionQueue *self, Collision *output);
+
+/**
+ * @brief Destroy the queue
+ * @param self The queue
+ */
+void CollisionQueue_destroy(CollisionQueue *self);
+
+#endif // COLLISION_H
@@ -1,6 +1,8 @@
 ﻿#include "controller.h"
 #include "utils.h"
 
+#include <stdlib.h>
+
 #include "tron.h"
 
 int Controller_get_height(const Controller* self)
@@ -28,9 +30,9 @@ int Controller_get_wall_count(const Controller* self)
     return self->game->model->num_walls;
 }
 
-Wall* Controller_get_wall(const Controller* self, const int index)
+Wall Controller_get_wall(const Controller* self, const int index)
 {
-    return &self->game->model->walls[index];
+    return Model_get_wall(self->game->model, index);
 }
 
 GameState Controller_get_state(const Controller* self)
@@ -38,6 +40,114 @@ GameState Controller_get_state(const Controller* self)
     return self->game->model->state;
 }
 
+void Controller_set_speed(Controller* self, const int speed)
+{
+    self->speed = speed > 0 ? speed : 1;
+}
+
+void Controller_set_storage(Controller* self, const ModelStorage storage)
+{
+    Model_set_storage(self->game->model, storage);
+}
+
+void Controller_set_mode(Controller* self, const GameMode mode, const int trail_lifetime, const int respawn_delay)
+{
+    Model_set_mode(self->game->model, mode, trail_lifetime, respawn_delay);
+}
+
+unsigned long long Controller_get_checksum(const Controller* self)
+{
+    return Model_get_checksum(self->game->model);
+}
+
+void Controller_set_checksum_logging(Controller* self, const bool enabled)
+{
+    self->log_checksum = enabled;
+}
+
+bool Controller_set_threads(Controller* self, const int threads)
+{
+    if (self->pool != NULL)
+    {
+        ThreadPool_destroy(self->pool);
+        free(self->pool);
+        self->pool = NULL;
+    }
+    if (threads <= 0)
+        return true;
+
+    self->pool = malloc(sizeof(ThreadPool));
+    if (self->pool == NULL)
+        return false;
+    if (!ThreadPool_init(self->pool, threads))
+    {
+        debug_log("Failed to start threads");
+        ThreadPool_destroy(self->pool);
+        free(self->pool);
+        self->pool = NULL;
+        return false;
+    }
+    return true;
+}
+
+void Controller_set_shard(Controller* self, Shard* shard)
+{
+    if (self->game->model->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the shard while playing");
+        return;
+    }
+    self->shard = shard;
+    if (shard == NULL)
+        Model_clear_window(self->game->model);
+}
+
+bool Controller_load_map(Controller* self, const char* path)
+{
+    if (self->game->model->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the map while playing");
+        return false;
+    }
+    Controller_unload_map(self);
+    if (!Map_open(&self->map, path))
+        return false;
+    Model_set_map(self->game->model, &self->map);
+    return true;
+}
+
+void Controller_unload_map(Controller* self)
+{
+    if (self->game->model->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the map while playing");
+        return;
+    }
+    Model_set_map(self->game->model, NULL);
+    Map_close(&self->map);
+}
+
+const Map* Controller_get_map(const Controller* self)
+{
+    return self->game->model->map;
+}
+
+void Controller_destroy(Controller* self)
+{
+    Controller_set_threads(self, 0);
+    Controller_unload_map(self);
+}
+
+unsigned long long Controller_get_event_cursor(const Controller* self)
+{
+    return Model_get_event_cursor(self->game->model);
+}
+
+EventReadResult Controller_read_event(const Controller* self, unsigned long long* cursor, Event* output)
+{
+    return Model_read_event(self->game->model, cursor, output);
+}
+
 void Controller_set_state(const Controller* self, const GameState state)
 {
     const GameState old_state = self->game->model->state;
@@ -73,8 +183,26 @@ void Controller_play(const Controller* self, const int width, const int height)
         debug_log("Game already playing");
         return;
     }
-    self->game->model->width = width;
-    self->game->model->height = height;
+    // the game area is the map, when there is one
+    const Map* map = Controller_get_map(self);
+    const int area_width = map != NULL ? map->width : width;
+    const int area_height = map != NULL ? map->height : height;
+    if (self->shard != NULL)
+    {
+        if (self->game->model->mode == GAME_MODE_ENDLESS)
+        {
+            debug_log("Endless mode cannot be sharded");
+            return;
+        }
+
+        // the halo holds the cells the players of the strip can reach in one update
+        const int halo = self->speed > 0 ? self->speed : 1;
+        int min_x, max_x;
+        Shard_get_columns(self->shard, area_width, &min_x, &max_x);
+        Model_set_window(self->game->model, min_x - halo, max_x + halo, 0, area_height - 1);
+    }
+    self->game->model->width = area_width;
+    self->game->model->height = area_height;
     Controller_set_state(self, GAME_STATE_PLAYING);
     debug_logf("New game state: %d", Controller_get_state(self));
 }
@@ -108,46 +236,119 @@ void Controller_new_player(Controller* self)
 
 void Controller_remove_player(Controller* self, const int index)
 {
+    // the queued turns belong to the players before the shift of the indices
+    Controller_clear_moves(self);
     Model_remove_player(self->game->model, index);
 }
 
+void Controller_evaluate_players(void* context, const int first, const int last)
+{
+    const Controller* self = context;
+    int min_x = 0;
+    int max_x = self->game->model->width - 1;
+    if (self->shard != NULL)
+        Shard_get_columns(self->shard, self->game->model->width, &min_x, &max_x);
+
+    for (int i = first; i < last; i++)
+    {
+        Player* player = Controller_get_player(self, i);
+        if (player->state == PLAYER_STATE_DEAD) continue;
+
+        // a shard only evaluates the players starting the update in its strip
+        int dx, dy;
+        Model_get_relative_direction(player->direction, &dx, &dy);
+        const int x = player->x - dx * player->moved;
+        player->collision = x >= min_x && x <= max_x ? Model_evaluate_player(self->game->model, i) : 0;
+    }
+}
+
+bool Controller_share_collisions(const Controller* self)
+{
+    // each player was evaluated by a single shard, the others have a collision of 0
+    const int num_players = self->game->model->num_players;
+    int* values = Shard_get_values(self->shard, num_players);
+    if (values == NULL)
+        return false;
+    for (int i = 0; i < num_players; i++)
+        values[i] = Controller_get_player(self, i)->collision;
+    if (!Shard_sum_values(self->shard))
+        return false;
+    for (int i = 0; i < num_players; i++)
+        Controller_get_player(self, i)->collision = values[i];
+    return true;
+}
+
+void Controller_apply_moves(Controller* self)
+{
+    const int num_players = self->game->model->num_players < MAX_PLAYERS
+                                ? self->game->model->num_players
+                                : MAX_PLAYERS;
+    for (int i = 0; i < num_players; i++)
+    {
+        // the first turn changing the direction, the older and the useless ones are dropped
+        ControllerInputQueue* queue = &self->inputs[i];
+        while (queue->count > 0)
+        {
+            const ControllerInput input = queue->inputs[queue->first];
+            queue->first = (queue->first + 1) % CONTROLLER_INPUT_QUEUE;
+            queue->count--;
+
+            Player* player = Controller_get_player(self, i);
+            if (player->state != PLAYER_STATE_ALIVE
+                || input.tick > self->game->model->tick
+                || self->game->model->tick - input.tick > CONTROLLER_INPUT_QUEUE
+                || input.direction == player->direction)
+                continue;
+            if (Model_change_direction(self->game->model, i, input.direction))
+                break;
+        }
+    }
+}
+
 void Controller_update(Controller* self)
 {
     if (self->game->model->state != GAME_STATE_PLAYING) return;
 
+    Model_advance(self->game->model);
+    Controller_apply_moves(self);
+
+    const int speed = self->speed > 0 ? self->speed : 1;
     for (int i = 0; i < self->game->model->num_players; i++)
     {
         Player* player = Controller_get_player(self, i);
         if (player->state != PLAYER_STATE_ALIVE) continue;
-        Model_move_player(self->game->model, i, 1);
+        Model_move_player(self->game->model, i, speed);
     }
 
-    for (int i = 0; i < self->game->model->num_players; i++)
+    // evaluate the moves against the walls, the model is only read so the players are split between the threads
+    const int num_players = self->game->model->num_players;
+    if (self->pool != NULL && num_players >= CONTROLLER_PARALLEL_MIN_PLAYERS)
+        ThreadPool_run(self->pool, num_players, CONTROLLER_PARALLEL_CHUNK, Controller_evaluate_players, self);
+    else
+        Controller_evaluate_players(self, 0, num_players);
+    if (self->shard != NULL && !Controller_share_collisions(self))
+    {
+        debug_log("Failed to share the collisions with the other shards");
+        Controller_set_state(self, GAME_STATE_GAME_OVER);
+        return;
+    }
+
+    // then commit the results in the order of the players, whatever the number of threads
+    for (int i = 0; i < num_players; i++)
     {
         Player* player = Controller_get_player(self, i);
-        const PlayerState state = player->state;
-        if (state == PLAYER_STATE_DEAD) continue;
-        Model_calculate_player_state(self->game->model, i);
+        if (player->state == PLAYER_STATE_DEAD) continue;
+        Model_apply_player_state(self->game->model, i, player->collision);
     }
+    Model_resolve_collisions(self->game->model);
 
-    Wall wall;
-    int distance;
     for (int i = 0; i < self->game->model->num_players; i++)
     {
         Player* player = Controller_get_player(self, i);
         if (player->state == PLAYER_STATE_TO_DEATH)
-        {
-            player->state = PLAYER_STATE_DEAD;
-            Direction opposite = Model_get_opposite_direction(player->direction);
-            Direction current = player->direction;
-            int dx, dy;
-            Model_get_relative_direction(opposite, &dx, &dy);
-            if (Model_try_hit_raycast(self->game->model, player->x + dx, player->y + dy, opposite, &wall, &distance))
-                Model_add_wall(self->game->model, player->x, player->y, current, distance, i);
-        }
-        else if (player->state == PLAYER_STATE_ALIVE)
-            player->score++;
+            Model_kill_player(self->game->model, i);
     }
+    Model_reward_survivors(self->game->model);
 
     int sum_player_alive = 0;
     for (int i = 0; i < self->game->model->num_players; i++)
@@ -157,7 +358,10 @@ void Controller_update(Controller* self)
             sum_player_alive++;
     }
 
-    if (sum_player_alive <= 1)
+    if (self->log_checksum)
+        debug_logf("[CHECKSUM] %d %016llx", self->game->model->tick, Controller_get_checksum(self));
+
+    if (sum_player_alive <= 1 && self->game->model->mode != GAME_MODE_ENDLESS)
         Controller_set_state(self, GAME_STATE_GAME_OVER);
 }
 
@@ -171,9 +375,41 @@ bool Controller_out_of_bounds(const Controller* self, const int x, const int y)
     return Model_out_of_bounds(self->game->model, x, y);
 }
 
+int Controller_get_free_neighbors(const Controller* self, const int x, const int y)
+{
+    return Model_get_free_neighbors(self->game->model, x, y);
+}
+
 void Controller_move_player(Controller* self, const int index, const Direction direction)
 {
     Player* player = Controller_get_player(self, index);
     if (player->state != PLAYER_STATE_ALIVE) return;
     Model_change_direction(self->game->model, index, direction);
 }
+
+bool Controller_queue_move(Controller* self, const int index, const Direction direction)
+{
+    if (index < 0 || index >= MAX_PLAYERS || index >= self->game->model->num_players) return false;
+
+    // a held key repeats the last turn, or the direction of the player
+    ControllerInputQueue* queue = &self->inputs[index];
+    const Direction last = queue->count > 0
+                               ? queue->inputs[(queue->first + queue->count - 1) % CONTROLLER_INPUT_QUEUE].direction
+                               : Controller_get_player(self, index)->direction;
+    if (direction == last) return true;
+    if (queue->count == CONTROLLER_INPUT_QUEUE) return false;
+
+    queue->inputs[(queue->first + queue->count) % CONTROLLER_INPUT_QUEUE] =
+        (ControllerInput){direction, self->game->model->tick};
+    queue->count++;
+    return true;
+}
+
+void Controller_clear_moves(Controller* self)
+{
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        self->inputs[i].first = 0;
+        self->inputs[i].count = 0;
+    }
+}
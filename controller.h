@@ -2,17 +2,41 @@
 #define CONTROLLER_H
 
 #include "model.h"
+#include "shard.h"
+#include "thread_pool.h"
 
-#define MAX_PLAYERS 6
+#define MAX_PLAYERS 6 // players with keyboard controls in the vues, the model takes up to MODEL_MAX_PLAYERS
 #define MIN_PLAYER 2
 #define DELAY 5
+#define CONTROLLER_PARALLEL_MIN_PLAYERS 256 // fewer players are evaluated on the calling thread
+#define CONTROLLER_PARALLEL_CHUNK 64 // players evaluated at once by a thread
+#define CONTROLLER_INPUT_QUEUE 8 // turns buffered for a player, and updates a turn waits at most before it is dropped
 
 // Forward declaration of the Tron struct
 typedef struct Tron Tron;
 
+// Turn asked by a player, applied at a later update
+typedef struct ControllerInput {
+    Direction direction;
+    int tick; // update of the model at which the turn was asked
+} ControllerInput;
+
+// Turns asked by a player, in order, in a ring of fixed size
+typedef struct ControllerInputQueue {
+    ControllerInput inputs[CONTROLLER_INPUT_QUEUE];
+    int first;
+    int count;
+} ControllerInputQueue;
+
 // Controller struct definition
 typedef struct Controller {
     Tron* game; // Pointer to the Tron game instance
+    int speed; // Cells moved by the players at each update
+    bool log_checksum; // Log the checksum of the game after each update
+    ThreadPool* pool; // Threads evaluating the players at each update, NULL to evaluate them on the calling thread
+    Shard* shard; // Process simulating a strip of the game area, NULL to simulate the whole area
+    Map map; // Map of the games, mapped in memory, not mapped for an empty game area
+    ControllerInputQueue inputs[MAX_PLAYERS]; // Turns of the players with keyboard controls, one applied per update
 } Controller;
 
 /**
@@ -55,9 +79,9 @@ int Controller_get_wall_count(const Controller* self);
  * @brief Get a wall by index.
  * @param self Pointer to the Controller instance.
  * @param index The index of the wall.
- * @return Pointer to the Wall instance.
+ * @return The unpacked wall.
  */
-Wall* Controller_get_wall(const Controller* self, const int index);
+Wall Controller_get_wall(const Controller* self, const int index);
 
 /**
  * @brief Get the current state of the game.
@@ -73,6 +97,108 @@ GameState Controller_get_state(const Controller* self);
  */
 void Controller_set_state(const Controller* self, const GameState state);
 
+/**
+ * @brief Set the number of cells moved by the players at each update.
+ * @param self Pointer to the Controller instance.
+ * @param speed The speed, at least 1.
+ */
+void Controller_set_speed(Controller* self, const int speed);
+
+/**
+ * @brief Set the storage of the walls of the next games.
+ * @param self Pointer to the Controller instance.
+ * @param storage The storage, MODEL_STORAGE_GRID or MODEL_STORAGE_SEGMENTS.
+ * @note The results of the games do not depend on the storage.
+ */
+void Controller_set_storage(Controller* self, const ModelStorage storage);
+
+/**
+ * @brief Set the game mode of the next games.
+ * @param self Pointer to the Controller instance.
+ * @param mode The game mode, GAME_MODE_CLASSIC or GAME_MODE_ENDLESS.
+ * @param trail_lifetime The number of updates a wall lasts in endless mode, 0 for no limit.
+ * @param respawn_delay The number of updates before a dead player respawns in endless mode.
+ */
+void Controller_set_mode(Controller* self, const GameMode mode, const int trail_lifetime, const int respawn_delay);
+
+/**
+ * @brief Get the checksum of the game, to compare two runs or two peers at each update.
+ * @param self Pointer to the Controller instance.
+ * @return The checksum of the game.
+ */
+unsigned long long Controller_get_checksum(const Controller* self);
+
+/**
+ * @brief Log the checksum of the game after each update.
+ * @param self Pointer to the Controller instance.
+ * @param enabled True to log the checksum, false otherwise.
+ */
+void Controller_set_checksum_logging(Controller* self, const bool enabled);
+
+/**
+ * @brief Set the number of threads evaluating the players at each update.
+ * @param self Pointer to the Controller instance.
+ * @param threads The number of threads besides the calling one, 0 to evaluate the players on the calling thread.
+ * @return True if the threads were started, false otherwise.
+ * @note The results of an update do not depend on the number of threads.
+ */
+bool Controller_set_threads(Controller* self, const int threads);
+
+/**
+ * @brief Simulate a strip of the game area, with the other shards simulating the rest.
+ * @param self Pointer to the Controller instance.
+ * @param shard Pointer to the shard of the process, NULL to simulate the whole area.
+ * @note Each shard keeps the walls of its strip and of a halo as wide as the speed, and moves all the players. A
+ * player is evaluated by the shard owning the cell it starts the update from, then the shards exchange their results,
+ * so all the shards resolve the collisions the same way as a single process. The players must receive the same moves
+ * in every shard, the speed must be set before playing, and the endless mode is not supported.
+ */
+void Controller_set_shard(Controller* self, Shard* shard);
+
+/**
+ * @brief Load the map of the next games.
+ * @param self Pointer to the Controller instance.
+ * @param path The path of the map file.
+ * @return True if the map was loaded, false otherwise.
+ * @note The game area takes the size of the map, and the players start on its start positions.
+ */
+bool Controller_load_map(Controller* self, const char* path);
+
+/**
+ * @brief Unload the map, the next games start on an empty game area.
+ * @param self Pointer to the Controller instance.
+ */
+void Controller_unload_map(Controller* self);
+
+/**
+ * @brief Get the map of the games.
+ * @param self Pointer to the Controller instance.
+ * @return Pointer to the map, NULL for an empty game area.
+ */
+const Map* Controller_get_map(const Controller* self);
+
+/**
+ * @brief Stop the threads of the controller, and unload the map.
+ * @param self Pointer to the Controller instance.
+ */
+void Controller_destroy(Controller* self);
+
+/**
+ * @brief Get the cursor of a new consumer of the game events.
+ * @param self Pointer to the Controller instance.
+ * @return The cursor, reading the events published from now on.
+ */
+unsigned long long Controller_get_event_cursor(const Controller* self);
+
+/**
+ * @brief Read the next game event of a consumer.
+ * @param self Pointer to the Controller instance.
+ * @param cursor Pointer to the cursor of the consumer.
+ * @param output Pointer to the Event instance to store the result.
+ * @return EVENT_READ_OK if an event was read, EVENT_READ_OVERRUN if the consumer must read the whole game again.
+ */
+EventReadResult Controller_read_event(const Controller* self, unsigned long long* cursor, Event* output);
+
 /**
  * @brief Add a new player to the game.
  * @param self Pointer to the Controller instance.
@@ -130,6 +256,15 @@ void Controller_get_player_wall(const Controller* self, const int index, Wall* o
  */
 bool Controller_out_of_bounds(const Controller* self, const int x, const int y);
 
+/**
+ * @brief Get the free neighbors of a cell.
+ * @param self Pointer to the Controller instance.
+ * @param x The x-coordinate.
+ * @param y The y-coordinate.
+ * @return A mask with the bit d set when the neighbor in the direction d is free and in the game area.
+ */
+int Controller_get_free_neighbors(const Controller* self, const int x, const int y);
+
 /**
  * @brief Move a player in a specified direction.
  * @param self Pointer to the Controller instance.
@@ -138,4 +273,20 @@ bool Controller_out_of_bounds(const Controller* self, const int x, const int y);
  */
 void Controller_move_player(Controller* self, const int index, const Direction direction);
 
+/**
+ * @brief Queue a turn of a player, applied at the next update without a turn of the player.
+ * @param self Pointer to the Controller instance.
+ * @param index The index of the player, a player with keyboard controls.
+ * @param direction The direction to turn to.
+ * @return True if the turn was queued, false if the queue is full (a repeated turn is ignored, and true).
+ * @note At most one turn of a player is applied at each update, so that two quick turns make a U-turn.
+ */
+bool Controller_queue_move(Controller* self, const int index, const Direction direction);
+
+/**
+ * @brief Drop the queued turns of all the players.
+ * @param self Pointer to the Controller instance.
+ */
+void Controller_clear_moves(Controller* self);
+
 #endif // CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "event_ring.h"
+
+#include <stdlib.h>
+
+bool EventRing_push(EventRing *self, const Event *event)
+{
+    if (self->events == NULL)
+    {
+        self->events = malloc(EVENT_RING_CAPACITY * sizeof(Event));
+        if (self->events == NULL)
+            return false;
+    }
+    self->events[self->head & (EVENT_RING_CAPACITY - 1)] = *event;
+    self->head++;
+    return true;
+}
+
+unsigned long long EventRing_get_head(const EventRing *self)
+{
+    return self->head;
+}
+
+EventReadResult EventRing_read(const EventRing *self, unsigned long long *cursor, Event *output)
+{
+    if (*cursor >= self->head)
+        return EVENT_READ_EMPTY;
+
+    // the slot of the event was reused by a newer one
+    if (self->head - *cursor > EVENT_RING_CAPACITY)
+    {
+        *cursor = self->head;
+        return EVENT_READ_OVERRUN;
+    }
+
+    *output = self->events[*cursor & (EVENT_RING_CAPACITY - 1)];
+    (*cursor)++;
+    return EVENT_READ_OK;
+}
+
+void EventRing_destroy(EventRing *self)
+{
+    free(self->events);
+    self->events = NULL;
+}
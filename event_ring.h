@@ -0,0 +1,78 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+#include <stdbool.h>
+
+typedef int EventType;
+enum {
+    EVENT_PLAYER_ADDED, // player
+    EVENT_PLAYER_REMOVED, // player, the players after it moved down by one
+    EVENT_PLAYER_TURNED, // player, x, y, direction: the new direction, at the position of the turn
+    EVENT_PLAYER_DIED, // player, x, y, direction: the last position of the player
+    EVENT_PLAYER_SPAWNED, // player, x, y, direction (endless mode)
+    EVENT_SCORE_CHANGED, // player, value: the new score, not published for the point of each update of the alive players
+    EVENT_WALL_ADDED, // index, player, x, y, direction, value: the length of the wall
+    EVENT_WALL_EXTENDED, // index, player, x, y, direction, value: the wall after it was merged with a new one
+    EVENT_WALL_REMOVED, // index, player
+    EVENT_WALLS_CLEARED, // all the walls were removed
+    EVENT_WALLS_COMPACTED, // value: the number of walls, their indices changed
+    EVENT_STATE_CHANGED, // value: the new game state
+    EVENT_RESTORED // the model was restored from a snapshot, the consumers must read the whole model again
+};
+
+// Change of the model, the fields used depend on the type
+typedef struct Event {
+    EventType type;
+    int tick; // update of the model at which the event happened
+    int player;
+    int index;
+    int x;
+    int y;
+    int direction;
+    int value;
+} Event;
+
+#define EVENT_RING_CAPACITY 4096 // must be a power of two
+// Bounded queue of the last events, each consumer reads it with its own cursor
+typedef struct EventRing {
+    Event *events; // allocated at the first event
+    unsigned long long head; // sequence number of the next event, events are never lost before it wraps
+} EventRing;
+
+typedef int EventReadResult;
+enum {
+    EVENT_READ_OK, // an event was read
+    EVENT_READ_EMPTY, // the consumer read every event
+    EVENT_READ_OVERRUN // events were overwritten before the consumer read them, it must read the whole model again
+};
+
+/**
+ * @brief Publish an event, overwriting the oldest one when the ring is full
+ * @param self The event ring
+ * @param event The event
+ * @return True if the event was published, false otherwise
+ */
+bool EventRing_push(EventRing *self, const Event *event);
+
+/**
+ * @brief Get the cursor of a new consumer, that only reads the events published from now on
+ * @param self The event ring
+ * @return The cursor
+ */
+unsigned long long EventRing_get_head(const EventRing *self);
+
+/**
+ * @brief Read the next event of a consumer
+ * @param self The event ring
+ * @param cursor The cursor of the consumer, advanced past the event read
+ * @param output The output event
+ * @return The result of the read, on an overrun the cursor skips to the newest event
+ */
+EventReadResult EventRing_read(const EventRing *self, unsigned long long *cursor, Event *output);
+
+/**
+ * @brief Free the events
+ * @param self The event ring
+ */
+void EventRing_destroy(EventRing *self);
+
+#endif // EVENT_RING_H
@@ -0,0 +1,45 @@
+#include "game_clock.h"
+
+#include <time.h>
+
+long long GameClock_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * GAME_CLOCK_SECOND + now.tv_nsec;
+}
+
+void GameClock_init(GameClock *self, const int updates_per_second)
+{
+    self->step = GAME_CLOCK_SECOND / (updates_per_second > 0 ? updates_per_second : 1);
+    GameClock_reset(self);
+}
+
+void GameClock_reset(GameClock *self)
+{
+    self->last = GameClock_now();
+    self->accumulator = 0;
+}
+
+int GameClock_advance(GameClock *self)
+{
+    const long long now = GameClock_now();
+    self->accumulator += now - self->last;
+    self->last = now;
+
+    int steps = (int)(self->accumulator / self->step < GAME_CLOCK_MAX_STEPS
+                          ? self->accumulator / self->step
+                          : GAME_CLOCK_MAX_STEPS);
+    self->accumulator -= steps * self->step;
+
+    // the time beyond the last update is dropped
+    if (self->accumulator >= self->step)
+        self->accumulator = self->step - 1;
+    return steps;
+}
+
+long long GameClock_until_next(const GameClock *self)
+{
+    const long long due = self->step - self->accumulator - (GameClock_now() - self->last);
+    return due > 0 ? due : 0;
+}
@@ -0,0 +1,48 @@
+#ifndef GAME_CLOCK_H
+#define GAME_CLOCK_H
+
+#define GAME_CLOCK_SECOND 1000000000LL // nanoseconds in a second
+#define GAME_CLOCK_MAX_STEPS 8 // updates run by an advance at most, a longer stall slows the game instead of the view
+
+// Fixed timestep clock: the time since the last advance is accumulated, and paid back in updates of a fixed duration
+typedef struct GameClock {
+    long long step; // duration of an update
+    long long last; // time of the last advance
+    long long accumulator; // time not simulated yet, less than a step after an advance
+} GameClock;
+
+/**
+ * @brief Get the time of the monotonic clock
+ * @return The time in nanoseconds, from an unspecified start
+ */
+long long GameClock_now(void);
+
+/**
+ * @brief Initialize a clock, starting now
+ * @param self The clock
+ * @param updates_per_second The number of updates of a second of game
+ */
+void GameClock_init(GameClock *self, const int updates_per_second);
+
+/**
+ * @brief Restart the clock from now, without any update due
+ * @param self The clock
+ * @note Called while the game is paused, so that the pause is not simulated afterwards
+ */
+void GameClock_reset(GameClock *self);
+
+/**
+ * @brief Get the number of updates due since the last advance
+ * @param self The clock
+ * @return The number of updates to run, at most GAME_CLOCK_MAX_STEPS
+ */
+int GameClock_advance(GameClock *self);
+
+/**
+ * @brief Get the time until the next update is due
+ * @param self The clock
+ * @return The time in nanoseconds, 0 if an update is already due
+ */
+long long GameClock_until_next(const GameClock *self);
+
+#endif // GAME_CLOCK_H
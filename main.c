@@ -1,8 +1,11 @@
 #include <stdlib.h>
 #include "tron.h"
 #include "utils.h"
+#include "vue_headless.h"
+#ifndef TRON_NO_UI
 #include "vue_sdl.h"
 #include "vue_ncurses.h"
+#endif
 
 int main(const int argc, char** argv)
 {
@@ -15,20 +18,35 @@ int main(const int argc, char** argv)
     debug_logf("Flags: %d", flags);
 
     // Initialize controller and model
-    Controller controller = {NULL};
+    Controller controller = {.game = NULL, .speed = 1};
     Model model = {NULL};
 
     Tron* tron;
+    VueHeadless vue_headless;
 
+    // Check if headless flag is set
+    if (flags & HEADLESS_FLAG)
+    {
+        // Initialize headless view from the options
+        if (!VueHeadless_init(&vue_headless, argv, argc))
+        {
+            debug_log("Invalid headless options");
+            return 1;
+        }
+        // Create Tron game without drawing
+        tron = create_tron(&model, (Vue*)&vue_headless, &controller);
+    }
+#ifndef TRON_NO_UI
     // Check if SDL flag is set
-    if (flags & SDL_FLAG)
+    else if (flags & SDL_FLAG)
     {
         // Initialize SDL view
         VueSDL vue_sdl = {
             {
                 NULL,
                 VueSDL_main
-            }
+            },
+            (flags & SOFTWARE_FLAG) != 0
         };
         // Create Tron game with SDL view
         tron = create_tron(&model, (Vue*)&vue_sdl, &controller);
@@ -46,6 +64,7 @@ int main(const int argc, char** argv)
         // Create Tron game with NCURSES view
         tron = create_tron(&model, (Vue*)&vue_ncurses, &controller);
     }
+#endif
     else
     {
         // No valid flags found, log and return error
@@ -53,10 +72,23 @@ int main(const int argc, char** argv)
         return 1;
     }
 
+    // Load the map of the games, if any
+    const char* map = find_option(argv, argc, MAP_OPTION_PROMPT);
+    if (map != NULL && !Controller_load_map(&controller, map))
+    {
+        debug_log("Failed to load map");
+        free(tron);
+        return 1;
+    }
+
+    // Log the checksum of the game after each update, to find where two runs diverge
+    Controller_set_checksum_logging(&controller, (flags & CHECKSUM_FLAG) != 0);
+
     // Run the main function of the view
     int io = tron->vue->main(tron->vue);
 
-    // Free the Tron game instance
+    // Stop the threads of the controller and free the Tron game instance
+    Controller_destroy(&controller);
     free(tron);
 
     return io;
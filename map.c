@@ -0,0 +1,215 @@
+#include "map.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+int Map_words(const int bits)
+{
+    return (bits + 63) / 64;
+}
+
+int Map_find_forward(const unsigned long long *words, const int from, const int to, const bool set)
+{
+    // first bit with the value in [from, to], a word at a time
+    const unsigned long long invert = set ? 0 : ~0ULL;
+    for (int w = from >> 6; w <= to >> 6; w++)
+    {
+        unsigned long long bits = words[w] ^ invert;
+        if (w == from >> 6)
+            bits &= ~0ULL << (from & 63);
+        if (bits == 0)
+            continue;
+        const int bit = (w << 6) + __builtin_ctzll(bits);
+        return bit <= to ? bit : -1;
+    }
+    return -1;
+}
+
+int Map_find_backward(const unsigned long long *words, const int from, const int to, const bool set)
+{
+    // last bit with the value in [to, from], a word at a time
+    const unsigned long long invert = set ? 0 : ~0ULL;
+    for (int w = from >> 6; w >= to >> 6; w--)
+    {
+        unsigned long long bits = words[w] ^ invert;
+        if (w == from >> 6 && (from & 63) != 63)
+            bits &= (1ULL << ((from & 63) + 1)) - 1;
+        if (bits == 0)
+            continue;
+        const int bit = (w << 6) + 63 - __builtin_clzll(bits);
+        return bit >= to ? bit : -1;
+    }
+    return -1;
+}
+
+bool Map_open(Map *self, const char *path)
+{
+    memset(self, 0, sizeof(Map));
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        debug_logf("Failed to open map %s", path);
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(MapHeader))
+    {
+        debug_logf("Invalid map %s", path);
+        close(fd);
+        return false;
+    }
+
+    // the mapping stays valid once the file is closed
+    void *data = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        debug_logf("Failed to map %s", path);
+        return false;
+    }
+    self->data = data;
+    self->size = status.st_size;
+
+    const MapHeader *header = data;
+    if (header->magic != MAP_MAGIC || header->version != MAP_VERSION || header->width == 0 || header->height == 0
+        || header->width > MAP_MAX_SIZE || header->height > MAP_MAX_SIZE || header->num_spawns > MAP_MAX_SIZE)
+    {
+        debug_logf("Invalid map header %s", path);
+        Map_close(self);
+        return false;
+    }
+    self->width = (int)header->width;
+    self->height = (int)header->height;
+    self->num_spawns = (int)header->num_spawns;
+    self->row_words = Map_words(self->width);
+    self->column_words = Map_words(self->height);
+
+    const size_t spawns_size = self->num_spawns * sizeof(MapSpawn);
+    const size_t rows_size = (size_t)self->height * self->row_words * sizeof(unsigned long long);
+    const size_t columns_size = (size_t)self->width * self->column_words * sizeof(unsigned long long);
+    if (self->size != sizeof(MapHeader) + spawns_size + rows_size + columns_size)
+    {
+        debug_logf("Invalid map size %s", path);
+        Map_close(self);
+        return false;
+    }
+    self->spawns = (const MapSpawn *)((const char *)data + sizeof(MapHeader));
+    self->rows = (const unsigned long long *)((const char *)self->spawns + spawns_size);
+    self->columns = (const unsigned long long *)((const char *)self->rows + rows_size);
+
+    for (int i = 0; i < self->num_spawns; i++)
+        if (self->spawns[i].x >= header->width || self->spawns[i].y >= header->height || self->spawns[i].direction > 3)
+        {
+            debug_logf("Invalid map spawn %s", path);
+            Map_close(self);
+            return false;
+        }
+    debug_logf("Map %s: %dx%d, %d spawns", path, self->width, self->height, self->num_spawns);
+    return true;
+}
+
+bool Map_write(const char *path, const int width, const int height, const unsigned char *cells,
+               const MapSpawn *spawns, const int num_spawns)
+{
+    if (width <= 0 || height <= 0 || width > MAP_MAX_SIZE || height > MAP_MAX_SIZE || num_spawns < 0)
+        return false;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+
+    const MapHeader header = {MAP_MAGIC, MAP_VERSION, width, height, num_spawns, 0};
+    bool written = fwrite(&header, sizeof(MapHeader), 1, file) == 1
+                   && fwrite(spawns, sizeof(MapSpawn), num_spawns, file) == (size_t)num_spawns;
+
+    // the rows layer, then the columns layer
+    const int row_words = Map_words(width);
+    const int column_words = Map_words(height);
+    unsigned long long *line = malloc((row_words > column_words ? row_words : column_words) * sizeof(unsigned long long));
+    written = written && line != NULL;
+    for (int y = 0; y < height && written; y++)
+    {
+        memset(line, 0, row_words * sizeof(unsigned long long));
+        for (int x = 0; x < width; x++)
+            if (cells[(size_t)y * width + x])
+                line[x >> 6] |= 1ULL << (x & 63);
+        written = fwrite(line, sizeof(unsigned long long), row_words, file) == (size_t)row_words;
+    }
+    for (int x = 0; x < width && written; x++)
+    {
+        memset(line, 0, column_words * sizeof(unsigned long long));
+        for (int y = 0; y < height; y++)
+            if (cells[(size_t)y * width + x])
+                line[y >> 6] |= 1ULL << (y & 63);
+        written = fwrite(line, sizeof(unsigned long long), column_words, file) == (size_t)column_words;
+    }
+    free(line);
+    return fclose(file) == 0 && written;
+}
+
+bool Map_is_obstacle(const Map *self, const int x, const int y)
+{
+    if (x < 0 || x >= self->width || y < 0 || y >= self->height)
+        return false;
+    return self->rows[(size_t)y * self->row_words + (x >> 6)] >> (x & 63) & 1;
+}
+
+int Map_raycast(const Map *self, const int x, const int y, const int dx, const int dy, const int limit)
+{
+    if (x < 0 || x >= self->width || y < 0 || y >= self->height)
+        return -1;
+    const int reach = limit >= 0 ? limit : self->width + self->height;
+
+    int hit;
+    if (dx > 0)
+    {
+        const int to = x + reach < self->width - 1 ? x + reach : self->width - 1;
+        hit = Map_find_forward(&self->rows[(size_t)y * self->row_words], x, to, true);
+        return hit >= 0 ? hit - x : -1;
+    }
+    if (dx < 0)
+    {
+        hit = Map_find_backward(&self->rows[(size_t)y * self->row_words], x, x - reach > 0 ? x - reach : 0, true);
+        return hit >= 0 ? x - hit : -1;
+    }
+    if (dy > 0)
+    {
+        const int to = y + reach < self->height - 1 ? y + reach : self->height - 1;
+        hit = Map_find_forward(&self->columns[(size_t)x * self->column_words], y, to, true);
+        return hit >= 0 ? hit - y : -1;
+    }
+    if (dy < 0)
+    {
+        hit = Map_find_backward(&self->columns[(size_t)x * self->column_words], y, y - reach > 0 ? y - reach : 0,
+                                true);
+        return hit >= 0 ? y - hit : -1;
+    }
+    return Map_is_obstacle(self, x, y) ? 0 : -1;
+}
+
+bool Map_next_run(const Map *self, const int y, const int x, int *min_x, int *max_x)
+{
+    if (y < 0 || y >= self->height || x >= self->width)
+        return false;
+    const unsigned long long *row = &self->rows[(size_t)y * self->row_words];
+    const int first = Map_find_forward(row, x > 0 ? x : 0, self->width - 1, true);
+    if (first < 0)
+        return false;
+    const int end = Map_find_forward(row, first, self->width - 1, false);
+    *min_x = first;
+    *max_x = end >= 0 ? end - 1 : self->width - 1;
+    return true;
+}
+
+void Map_close(Map *self)
+{
+    if (self->data != NULL)
+        munmap(self->data, self->size);
+    memset(self, 0, sizeof(Map));
+}
@@ -0,0 +1,104 @@
+#ifndef MAP_H
+#define MAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MAP_MAGIC 0x50414d54 // "TMAP" in little endian
+#define MAP_VERSION 1
+#define MAP_MAX_SIZE (1 << 20) // largest width and height of a map
+
+// Header of a map file, followed by the spawns, the rows layer and the columns layer (little endian)
+typedef struct MapHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int width;
+    unsigned int height;
+    unsigned int num_spawns;
+    unsigned int reserved;
+} MapHeader;
+
+// Start position of a player
+typedef struct MapSpawn {
+    unsigned int x;
+    unsigned int y;
+    unsigned int direction;
+    unsigned int reserved;
+} MapSpawn;
+
+// Map file mapped in memory: the obstacles are read in place, as a bit per cell, once by rows and once by columns
+typedef struct Map {
+    void *data;
+    size_t size;
+    int width;
+    int height;
+    const MapSpawn *spawns;
+    int num_spawns;
+    const unsigned long long *rows; // bit x % 64 of word y * row_words + x / 64 is set for an obstacle
+    int row_words;
+    const unsigned long long *columns; // bit y % 64 of word x * column_words + y / 64 is set for an obstacle
+    int column_words;
+} Map;
+
+/**
+ * @brief Map a map file in memory
+ * @param self The output map
+ * @param path The path of the file
+ * @return True if the map was opened, false otherwise
+ * @note Only the header is checked, the pages of the obstacles are read when they are first used and are shared by
+ * all the processes mapping the same file
+ */
+bool Map_open(Map *self, const char *path);
+
+/**
+ * @brief Write a map file
+ * @param path The path of the file
+ * @param width The width of the map
+ * @param height The height of the map
+ * @param cells The cells of the map by rows, non zero for an obstacle
+ * @param spawns The start positions of the players
+ * @param num_spawns The number of start positions
+ * @return True if the file was written, false otherwise
+ */
+bool Map_write(const char *path, const int width, const int height, const unsigned char *cells,
+               const MapSpawn *spawns, const int num_spawns);
+
+/**
+ * @brief Check if a cell is an obstacle
+ * @param self The map
+ * @param x The x position
+ * @param y The y position
+ * @return True if the cell is an obstacle, false otherwise (and out of the map)
+ */
+bool Map_is_obstacle(const Map *self, const int x, const int y);
+
+/**
+ * @brief Find the first obstacle from a cell in a direction
+ * @param self The map
+ * @param x The x position, in the map
+ * @param y The y position, in the map
+ * @param dx The x step, -1, 0 or 1
+ * @param dy The y step, -1, 0 or 1
+ * @param limit The largest distance to look at, -1 for the edge of the map
+ * @return The distance to the obstacle, 0 for the cell itself, -1 if there is none
+ * @note The cells are scanned 64 at a time, in the rows layer or in the columns layer
+ */
+int Map_raycast(const Map *self, const int x, const int y, const int dx, const int dy, const int limit);
+
+/**
+ * @brief Find the first run of obstacles of a row at or after a column
+ * @param self The map
+ * @param y The row
+ * @param x The first column to look at
+ * @param min_x The output first column of the run
+ * @param max_x The output last column of the run
+ * @return True if there is a run, false otherwise
+ */
+bool Map_next_run(const Map *self, const int y, const int x, int *min_x, int *max_x);
+
+/**
+ * @brief Unmap the map file
+ * @param self The map
+ */
+void Map_close(Map *self);
+
+#endif // MAP_H
@@ -3,6 +3,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "utils.h"
 
@@ -15,16 +16,184 @@ void Model_init(Model* self, int width, int height)
     self->num_players = 0;
     self->walls = NULL;
     self->num_walls = 0;
+    TileGrid_clear(&self->grid);
+    self->rows = NULL;
+    self->num_rows = 0;
+    self->columns = NULL;
+    self->num_columns = 0;
+    self->storage = MODEL_STORAGE_GRID;
+    self->segments = (Segments){NULL, NULL, NULL, NULL, NULL, 0, 0};
+    self->arena = (Arena){NULL, NULL};
+    self->sweeps = (SweepHash){0};
+    self->collisions = (CollisionQueue){NULL, 0, 0};
+    self->links = NULL;
+    self->num_removed_walls = 0;
+    self->oldest_wall = 0;
+    self->log = (ModelLog){0};
+    self->mode = GAME_MODE_CLASSIC;
+    self->trail_lifetime = 0;
+    self->respawn_delay = 0;
+    self->tick = 0;
+    self->random = 0x853c49e6748fea9bULL;
+    self->checksum = 0;
+    self->events = (EventRing){NULL, 0};
+    self->windowed = false;
+    self->map = NULL;
     self->state = GAME_STATE_MENU;
 }
 
+unsigned long long Model_mix(unsigned long long z)
+{
+    // splitmix64 finalizer
+    z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+    return z ^ z >> 31;
+}
+
+unsigned long long Model_hash_wall(const PackedWall* wall)
+{
+    return Model_mix(Model_mix((unsigned long long)wall->x << 32 | wall->y)
+                     ^ ((unsigned long long)wall->length << 16 | wall->info));
+}
+
+unsigned long long Model_hash_player(const Model* self, const int index)
+{
+    // the score is left out, it follows from the states of the previous updates
+    const Player* player = &self->players[index];
+    const unsigned long long position = (unsigned long long)(unsigned int)player->x << 32 | (unsigned int)player->y;
+    const unsigned long long info = (unsigned long long)index << 32 | (unsigned int)(player->direction << 8 | player->state);
+    return Model_mix(Model_mix(Model_mix(position) ^ info) ^ (unsigned int)player->trail_length);
+}
+
+void Model_toggle_player(Model* self, const int index)
+{
+    self->checksum ^= Model_hash_player(self, index);
+}
+
+void Model_rehash(Model* self)
+{
+    // the checksum is the xor of the hashes of the walls and of the players
+    self->checksum = 0;
+    for (int i = 0; i < self->num_walls; i++)
+        if (self->walls[i].length > 0)
+            self->checksum ^= Model_hash_wall(&self->walls[i]);
+    for (int i = 0; i < self->num_players; i++)
+        Model_toggle_player(self, i);
+}
+
+void Model_emit(Model* self, const EventType type, const int player, const int index, const int x, const int y,
+                const int direction, const int value)
+{
+    const Event event = {type, self->tick, player, index, x, y, direction, value};
+    if (!EventRing_push(&self->events, &event))
+        debug_log("Failed to publish event");
+}
+
+void Model_emit_player(Model* self, const EventType type, const int index, const int value)
+{
+    const Player* player = &self->players[index];
+    Model_emit(self, type, index, -1, player->x, player->y, player->direction, value);
+}
+
+void Model_emit_wall(Model* self, const EventType type, const int index)
+{
+    const PackedWall* wall = &self->walls[index];
+    Model_emit(self, type, wall->info >> 2, index, (int)wall->x, (int)wall->y, wall->info & 3, wall->length);
+}
+
+void Model_set_state(Model* self, const GameState state)
+{
+    self->state = state;
+    Model_emit(self, EVENT_STATE_CHANGED, -1, -1, 0, 0, 0, state);
+}
+
+void Model_set_storage(Model* self, const ModelStorage storage)
+{
+    if (self->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the storage while playing");
+        return;
+    }
+    self->storage = storage;
+}
+
+void Model_set_map(Model* self, const Map* map)
+{
+    if (self->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the map while playing");
+        return;
+    }
+    self->map = map;
+}
+
+void Model_set_mode(Model* self, const GameMode mode, const int trail_lifetime, const int respawn_delay)
+{
+    if (self->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the mode while playing");
+        return;
+    }
+    self->mode = mode;
+    self->trail_lifetime = trail_lifetime > 0 ? trail_lifetime : 0;
+    self->respawn_delay = respawn_delay > 0 ? respawn_delay : 0;
+}
+
+void Model_set_window(Model* self, const int min_x, const int max_x, const int min_y, const int max_y)
+{
+    if (self->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the window while playing");
+        return;
+    }
+    self->windowed = true;
+    self->window_min_x = min_x;
+    self->window_max_x = max_x;
+    self->window_min_y = min_y;
+    self->window_max_y = max_y;
+}
+
+void Model_clear_window(Model* self)
+{
+    if (self->state == GAME_STATE_PLAYING)
+    {
+        debug_log("Cannot change the window while playing");
+        return;
+    }
+    self->windowed = false;
+}
+
+void Model_get_window(const Model* self, int* min_x, int* max_x, int* min_y, int* max_y)
+{
+    *min_x = 0;
+    *max_x = self->width - 1;
+    *min_y = 0;
+    *max_y = self->height - 1;
+    if (!self->windowed)
+        return;
+    *min_x = self->window_min_x > *min_x ? self->window_min_x : *min_x;
+    *max_x = self->window_max_x < *max_x ? self->window_max_x : *max_x;
+    *min_y = self->window_min_y > *min_y ? self->window_min_y : *min_y;
+    *max_y = self->window_max_y < *max_y ? self->window_max_y : *max_y;
+}
+
+bool Model_in_window(const Model* self, const int x, const int y)
+{
+    if (Model_out_of_bounds(self, x, y))
+        return false;
+    return !self->windowed || (self->window_min_x <= x && x <= self->window_max_x
+                               && self->window_min_y <= y && y <= self->window_max_y);
+}
+
 bool Model_add_player(Model* self, const int x, const int y, const int direction)
 {
-    // use allocated_player to resize the array
-    int allocated_players = self->allocated_players;
-    int to_allocate = (self->num_players + 1) + PLAYER_CHUNK - (self->num_players + 1) % PLAYER_CHUNK;
-    if (allocated_players < to_allocate)
+    if (self->num_players >= MODEL_MAX_PLAYERS)
+        return false;
+
+    // players outlive the games, they grow geometrically outside of the arena
+    if (self->num_players == self->allocated_players)
     {
+        const int to_allocate = self->allocated_players > 0 ? self->allocated_players * 2 : MODEL_INITIAL_PLAYERS;
         Player* tmp = realloc(self->players, to_allocate * sizeof(Player));
         if (tmp == NULL)
             return false;
@@ -37,50 +206,318 @@ bool Model_add_player(Model* self, const int x, const int y, const int direction
     self->players[self->num_players].direction = direction;
     self->players[self->num_players].score = 0;
     self->players[self->num_players].state = PLAYER_STATE_ALIVE;
+    self->players[self->num_players].trail_x = x;
+    self->players[self->num_players].trail_y = y;
+    self->players[self->num_players].trail_length = 0;
+    self->players[self->num_players].last_wall = -1;
+    self->players[self->num_players].moved = 0;
+    self->players[self->num_players].collision = 0;
+    self->players[self->num_players].respawn_tick = 0;
     self->num_players++;
+    Model_toggle_player(self, self->num_players - 1);
+    Model_emit_player(self, EVENT_PLAYER_ADDED, self->num_players - 1, 0);
+    return true;
+}
+
+bool Model_reserve(void** array, int* allocated, const int needed, const size_t size)
+{
+    if (needed <= *allocated)
+        return true;
+    int to_allocate = *allocated > 0 ? *allocated * 2 : MODEL_LOG_INITIAL_CAPACITY;
+    while (to_allocate < needed)
+        to_allocate *= 2;
+    void* tmp = realloc(*array, to_allocate * size);
+    if (tmp == NULL)
+        return false;
+    *array = tmp;
+    *allocated = to_allocate;
+    return true;
+}
+
+bool Model_set_cell(Model* self, const int x, const int y, const Cell cell)
+{
+    const Cell old = TileGrid_get(&self->grid, x, y);
+    if (old == cell)
+        return true;
+
+    if (self->log.num_snapshots > 0)
+    {
+        ModelLog* log = &self->log;
+        if (!Model_reserve((void**)&log->cells, &log->allocated_cells, log->num_cells + 1, sizeof(CellChange)))
+            return false;
+        log->cells[log->num_cells++] = (CellChange){x, y, old};
+    }
+
+    if (!TileGrid_set(&self->grid, &self->arena, x, y, cell))
+        return false;
+
+    // small game areas use the bitboard as their index
+    if (self->bitboard.kernels != NULL)
+    {
+        Bitboard_set(&self->bitboard, x, y, cell != CELL_EMPTY);
+        return true;
+    }
+
+    // the index only changes when the cell is taken or freed
+    if (old == CELL_EMPTY)
+        return SpanList_insert(&self->rows[y], &self->arena, x, x)
+               && SpanList_insert(&self->columns[x], &self->arena, y, y);
+    if (cell == CELL_EMPTY)
+        return SpanList_remove(&self->rows[y], &self->arena, x, x)
+               && SpanList_remove(&self->columns[x], &self->arena, y, y);
+    return true;
+}
+
+bool Model_log_wall(Model* self, const int index)
+{
+    if (self->log.num_snapshots == 0)
+        return true;
+
+    ModelLog* log = &self->log;
+    if (!Model_reserve((void**)&log->walls, &log->allocated_walls, log->num_walls + 1, sizeof(WallChange)))
+        return false;
+    WallChange* change = &log->walls[log->num_walls++];
+    change->index = index;
+    change->wall = self->walls[index];
+    change->link = self->links != NULL ? self->links[index] : (WallLink){-1, 0};
+    return true;
+}
+
+bool Model_fill_wall(Model* self, const int x, const int y, const int direction, const int length,
+                     const int player)
+{
+    if (self->rows == NULL)
+        return true;
+
+    // a wall covers the cells behind its position, in the opposite of its direction
+    int dx, dy;
+    Model_get_relative_direction(Model_get_opposite_direction(direction), &dx, &dy);
+
+    int cx = x;
+    int cy = y;
+    for (int i = 0; i < length; i++)
+    {
+        if (Model_in_window(self, cx, cy) && !Model_set_cell(self, cx, cy, (Cell)(player + 1)))
+            return false;
+        cx += dx;
+        cy += dy;
+    }
+    return true;
+}
+
+PackedWall Model_pack_wall(const int min_x, const int max_x, const int min_y, const int max_y,
+                           const Direction direction, const int player)
+{
+    // the position of a wall is its end in its direction
+    PackedWall wall;
+    wall.x = (unsigned int)(direction == DIRECTION_RIGHT ? max_x : min_x);
+    wall.y = (unsigned int)(direction == DIRECTION_DOWN ? max_y : min_y);
+    wall.length = (unsigned short)(max_x - min_x + max_y - min_y + 1);
+    wall.info = (unsigned short)(direction | player << 2);
+    return wall;
+}
+
+Wall Model_get_wall(const Model* self, const int index)
+{
+    const PackedWall* packed = &self->walls[index];
+    Wall wall;
+    wall.x = packed->x;
+    wall.y = packed->y;
+    wall.direction = packed->info & 3;
+    wall.length = packed->length;
+    wall.player = packed->info >> 2;
+    return wall;
+}
+
+bool Model_coalesce_wall(Model* self, const int player, const Direction direction,
+                         int min_x, int max_x, int min_y, int max_y)
+{
+    // in endless mode each wall keeps the update it was added at
+    const int index = self->players[player].last_wall;
+    if (index < 0 || self->mode == GAME_MODE_ENDLESS)
+        return false;
+
+    // the last wall of the player must be on the same line
+    const Wall last = Model_get_wall(self, index);
+    const bool horizontal = direction == DIRECTION_LEFT || direction == DIRECTION_RIGHT;
+    const bool last_horizontal = last.direction == DIRECTION_LEFT || last.direction == DIRECTION_RIGHT;
+    if (horizontal != last_horizontal)
+        return false;
+
+    int last_min_x, last_max_x, last_min_y, last_max_y;
+    Model_get_wall_bounds(last.x, last.y, last.direction, last.length,
+                          &last_min_x, &last_max_x, &last_min_y, &last_max_y);
+    if (horizontal
+            ? last_min_y != min_y || min_x > last_max_x + 1 || max_x < last_min_x - 1
+            : last_min_x != min_x || min_y > last_max_y + 1 || max_y < last_min_y - 1)
+        return false;
+
+    // extend it to cover both, if the result still fits in a packed wall
+    if ((max_x > last_max_x ? max_x : last_max_x) - (min_x < last_min_x ? min_x : last_min_x)
+        + (max_y > last_max_y ? max_y : last_max_y) - (min_y < last_min_y ? min_y : last_min_y) + 1
+        > MODEL_MAX_WALL_LENGTH)
+        return false;
+    min_x = min_x < last_min_x ? min_x : last_min_x;
+    max_x = max_x > last_max_x ? max_x : last_max_x;
+    min_y = min_y < last_min_y ? min_y : last_min_y;
+    max_y = max_y > last_max_y ? max_y : last_max_y;
+    if (!Model_log_wall(self, index))
+        return false;
+    self->checksum ^= Model_hash_wall(&self->walls[index]);
+    self->walls[index] = Model_pack_wall(min_x, max_x, min_y, max_y, direction, player);
+    self->checksum ^= Model_hash_wall(&self->walls[index]);
+    if (self->storage == MODEL_STORAGE_SEGMENTS)
+    {
+        self->segments.min_x[index] = min_x;
+        self->segments.max_x[index] = max_x;
+        self->segments.min_y[index] = min_y;
+        self->segments.max_y[index] = max_y;
+    }
+    Model_emit_wall(self, EVENT_WALL_EXTENDED, index);
     return true;
 }
 
 bool Model_add_wall(Model* self, const int x, const int y, const int direction, const int length, const int player)
 {
-    // use allocated_walls to resize the array
-    int allocated_walls = self->allocated_walls;
-    int to_allocate = (self->num_walls + 1) + WALL_CHUNK - (self->num_walls + 1) % WALL_CHUNK;
-    if (allocated_walls < to_allocate)
+    // clip the wall to the window of the game area
+    int min_x, max_x, min_y, max_y;
+    int window_min_x, window_max_x, window_min_y, window_max_y;
+    Model_get_wall_bounds(x, y, direction, length, &min_x, &max_x, &min_y, &max_y);
+    Model_get_window(self, &window_min_x, &window_max_x, &window_min_y, &window_max_y);
+    min_x = min_x < window_min_x ? window_min_x : min_x;
+    min_y = min_y < window_min_y ? window_min_y : min_y;
+    max_x = max_x > window_max_x ? window_max_x : max_x;
+    max_y = max_y > window_max_y ? window_max_y : max_y;
+    if (length <= 0 || min_x > max_x || min_y > max_y)
+        return true;
+
+    // split the walls too long to be packed, the tail first
+    const int clipped_length = max_x - min_x + max_y - min_y + 1;
+    if (clipped_length > MODEL_MAX_WALL_LENGTH)
     {
-        Wall* tmp = realloc(self->walls, to_allocate * sizeof(Wall));
+        int dx, dy;
+        Model_get_relative_direction(direction, &dx, &dy);
+        const int head_x = direction == DIRECTION_RIGHT ? max_x : min_x;
+        const int head_y = direction == DIRECTION_DOWN ? max_y : min_y;
+        return Model_add_wall(self, head_x - dx * MODEL_MAX_WALL_LENGTH, head_y - dy * MODEL_MAX_WALL_LENGTH,
+                              direction, clipped_length - MODEL_MAX_WALL_LENGTH, player)
+               && Model_add_wall(self, head_x, head_y, direction, MODEL_MAX_WALL_LENGTH, player);
+    }
+
+    // keep the occupancy grid and the raycast index in sync
+    if (self->storage == MODEL_STORAGE_GRID && !Model_fill_wall(self, x, y, direction, length, player))
+        return false;
+
+    if (Model_coalesce_wall(self, player, direction, min_x, max_x, min_y, max_y))
+        return true;
+
+    // walls grow geometrically in the arena
+    if (self->num_walls == self->allocated_walls)
+    {
+        const int to_allocate = self->allocated_walls > 0 ? self->allocated_walls * 2 : MODEL_INITIAL_WALLS;
+        PackedWall* tmp = Arena_grow(&self->arena, self->walls, self->allocated_walls * sizeof(PackedWall),
+                                     to_allocate * sizeof(PackedWall));
         if (tmp == NULL)
             return false;
         self->walls = tmp;
+        if (self->mode == GAME_MODE_ENDLESS)
+        {
+            WallLink* links = Arena_grow(&self->arena, self->links, self->allocated_walls * sizeof(WallLink),
+                                         to_allocate * sizeof(WallLink));
+            if (links == NULL)
+                return false;
+            self->links = links;
+        }
         self->allocated_walls = to_allocate;
     }
-    self->walls[self->num_walls].x = x;
-    self->walls[self->num_walls].y = y;
-    self->walls[self->num_walls].direction = direction;
-    self->walls[self->num_walls].length = length;
-    self->walls[self->num_walls].player = player;
+
+    // segments are kept at the same index as their wall
+    if (self->storage == MODEL_STORAGE_SEGMENTS
+        && !Segments_add(&self->segments, &self->arena, min_x, max_x, min_y, max_y, player))
+        return false;
+
+    if (self->num_walls < self->log.max_walls && !Model_log_wall(self, self->num_walls))
+        return false;
+    self->walls[self->num_walls] = Model_pack_wall(min_x, max_x, min_y, max_y, direction, player);
+    self->checksum ^= Model_hash_wall(&self->walls[self->num_walls]);
+    if (self->mode == GAME_MODE_ENDLESS)
+    {
+        self->links[self->num_walls].previous = self->players[player].last_wall;
+        self->links[self->num_walls].tick = self->tick;
+    }
+    self->players[player].last_wall = self->num_walls;
+    Model_emit_wall(self, EVENT_WALL_ADDED, self->num_walls);
     self->num_walls++;
     return true;
 }
 
 void Model_clear_walls(Model* self)
 {
-    free(self->walls);
+    // everything the game allocated lives in the arena
+    Arena_reset(&self->arena);
     self->walls = NULL;
     self->num_walls = 0;
     self->allocated_walls = 0;
+    self->links = NULL;
+    self->num_removed_walls = 0;
+    self->oldest_wall = 0;
+    self->log.num_cells = 0;
+    self->log.num_walls = 0;
+    self->log.num_players = 0;
+    self->log.num_snapshots = 0;
+    self->log.max_walls = 0;
+    TileGrid_clear(&self->grid);
+    self->bitboard.kernels = NULL;
+    self->rows = NULL;
+    self->num_rows = 0;
+    self->columns = NULL;
+    self->num_columns = 0;
+    self->segments = (Segments){NULL, NULL, NULL, NULL, NULL, 0, 0};
+    for (int i = 0; i < self->num_players; i++)
+        self->players[i].last_wall = -1;
+    Model_rehash(self);
+    Model_emit(self, EVENT_WALLS_CLEARED, -1, -1, 0, 0, 0, 0);
+}
+
+bool Model_allocate_grid(Model* self)
+{
+    // the tiles of the grid are allocated as the trails enter them, the index has a list per row and column
+    TileGrid_clear(&self->grid);
+    self->rows = Arena_alloc(&self->arena, self->height * sizeof(SpanList));
+    self->columns = Arena_alloc(&self->arena, self->width * sizeof(SpanList));
+    if (self->rows == NULL || self->columns == NULL)
+    {
+        self->rows = NULL;
+        self->columns = NULL;
+        return false;
+    }
+
+    memset(self->rows, 0, self->height * sizeof(SpanList));
+    memset(self->columns, 0, self->width * sizeof(SpanList));
+    self->num_rows = self->height;
+    self->num_columns = self->width;
+
+    // the kernels of the size class of the game area, if it is small enough
+    if (Bitboard_init(&self->bitboard, self->width, self->height))
+        debug_logf("Bitboard of %d cells", self->bitboard.kernels->bits);
+    return true;
 }
 
 void Model_destroy(Model* self)
 {
+    Model_clear_walls(self);
+    Arena_destroy(&self->arena);
+    free(self->log.cells);
+    free(self->log.walls);
+    free(self->log.players);
+    self->log = (ModelLog){0};
+    SweepHash_destroy(&self->sweeps);
+    CollisionQueue_destroy(&self->collisions);
+    EventRing_destroy(&self->events);
     free(self->players);
-    free(self->walls);
     self->players = NULL;
-    self->walls = NULL;
     self->num_players = 0;
-    self->num_walls = 0;
     self->allocated_players = 0;
-    self->allocated_walls = 0;
 }
 
 Direction Model_get_opposite_direction(const Direction direction)
@@ -116,15 +553,136 @@ bool Model_hit_wall(const Wall* wall, const int x, const int y)
     }
 }
 
-bool Model_try_hit_walls(const Model* model, const int x, const int y, Wall* output)
+void Model_get_wall_bounds(const int x, const int y, const Direction direction, const int length,
+                           int* min_x, int* max_x, int* min_y, int* max_y)
+{
+    *min_x = *max_x = x;
+    *min_y = *max_y = y;
+    switch (direction)
+    {
+    case DIRECTION_UP:
+        *max_y = y + length - 1;
+        break;
+    case DIRECTION_DOWN:
+        *min_y = y - length + 1;
+        break;
+    case DIRECTION_LEFT:
+        *max_x = x + length - 1;
+        break;
+    case DIRECTION_RIGHT:
+        *min_x = x - length + 1;
+        break;
+    default: ;
+    }
+}
+
+bool Model_get_live_trail_bounds(const Model* model, const int index, int* min_x, int* max_x, int* min_y, int* max_y)
+{
+    // the live trail without the head of the player, or without the cells of a move not resolved yet
+    const Player* player = &model->players[index];
+    const int ahead = player->moved > 0 ? player->moved : 1;
+    if (player->trail_length <= ahead)
+        return false;
+    int dx, dy;
+    Model_get_relative_direction(player->direction, &dx, &dy);
+    Model_get_wall_bounds(player->x - dx * ahead, player->y - dy * ahead, player->direction,
+                          player->trail_length - ahead, min_x, max_x, min_y, max_y);
+    return true;
+}
+
+bool Model_try_hit_segments(const Model* model, const int x, const int y, Wall* output)
+{
+    const Segments* segments = &model->segments;
+    int min_x, max_x, min_y, max_y;
+    const int i = Segments_first_hit(segments, x, y);
+    if (i >= 0)
+    {
+        min_x = segments->min_x[i];
+        max_x = segments->max_x[i];
+        min_y = segments->min_y[i];
+        max_y = segments->max_y[i];
+        output->player = segments->owner[i];
+    }
+    else
+    {
+        // live trails are not segments yet
+        int j = 0;
+        for (; j < model->num_players; j++)
+            if (Model_get_live_trail_bounds(model, j, &min_x, &max_x, &min_y, &max_y)
+                && min_x <= x && x <= max_x && min_y <= y && y <= max_y)
+                break;
+        if (j == model->num_players)
+            return false;
+        output->player = j;
+    }
+
+    // normalized segments are walls going up or left
+    output->x = min_x;
+    output->y = min_y;
+    output->direction = min_x == max_x ? DIRECTION_UP : DIRECTION_LEFT;
+    output->length = min_x == max_x ? max_y - min_y + 1 : max_x - min_x + 1;
+    return true;
+}
+
+int Model_get_cell_owner(const Model* model, const int x, const int y)
 {
-    for (int i = 0; i < model->num_walls; i++)
-        if (Model_hit_wall(&model->walls[i], x, y))
+    if (Model_out_of_bounds(model, x, y))
+        return -1;
+    if (model->map != NULL && Map_is_obstacle(model->map, x, y))
+        return MODEL_OBSTACLE;
+    if (model->storage == MODEL_STORAGE_SEGMENTS)
+    {
+        Wall wall;
+        return Model_try_hit_segments(model, x, y, &wall) ? wall.player : -1;
+    }
+    if (model->rows == NULL)
+        return -1;
+    if (model->bitboard.kernels != NULL && !Bitboard_get(&model->bitboard, x, y))
+        return -1;
+    return TileGrid_get(&model->grid, x, y) - 1;
+}
+
+int Model_get_free_neighbors(const Model* model, const int x, const int y)
+{
+    int mask = 0;
+    if (model->storage == MODEL_STORAGE_GRID && model->bitboard.kernels != NULL && !Model_out_of_bounds(model, x, y))
+        mask = Bitboard_free_neighbors(&model->bitboard, x, y);
+    else
+        for (Direction direction = DIRECTION_UP; direction <= DIRECTION_RIGHT; direction++)
         {
-            *output = model->walls[i];
-            return true;
+            int dx, dy;
+            Model_get_relative_direction(direction, &dx, &dy);
+            if (!Model_out_of_bounds(model, x + dx, y + dy) && Model_get_cell_owner(model, x + dx, y + dy) < 0)
+                mask |= 1 << direction;
         }
-    return false;
+
+    // the obstacles of the map are not in the bitboard
+    if (model->map != NULL)
+        for (Direction direction = DIRECTION_UP; direction <= DIRECTION_RIGHT; direction++)
+        {
+            int dx, dy;
+            Model_get_relative_direction(direction, &dx, &dy);
+            if (Map_is_obstacle(model->map, x + dx, y + dy))
+                mask &= ~(1 << direction);
+        }
+    return mask;
+}
+
+bool Model_try_hit_walls(const Model* model, const int x, const int y, Wall* output)
+{
+    if (model->storage == MODEL_STORAGE_SEGMENTS && (model->map == NULL || !Map_is_obstacle(model->map, x, y)))
+        return !Model_out_of_bounds(model, x, y) && Model_try_hit_segments(model, x, y, output);
+
+    const int owner = Model_get_cell_owner(model, x, y);
+    if (owner < 0)
+        return false;
+
+    output->x = x;
+    output->y = y;
+    output->direction = DIRECTION_UP;
+    output->length = 1;
+    output->player = owner;
+    return true;
 }
 
 bool Model_hit_player(const Player* player, const int x, const int y)
@@ -181,12 +739,88 @@ void Model_get_relative_direction(Direction direction, int* dx, int* dy)
     dy = 0;
 }
 
-bool Model_try_hit_raycast(const Model* model, const int x, const int y, const int direction, Wall* output,
-                           int* distance)
+bool Model_raycast_segments(const Model* model, int* cx, int* cy, const int direction)
 {
     int dx, dy;
     Model_get_relative_direction(direction, &dx, &dy);
 
+    int best;
+    Segments_raycast(&model->segments, *cx, *cy, dx, dy, &best);
+
+    // live trails are not segments yet
+    int min_x, max_x, min_y, max_y;
+    for (int i = 0; i < model->num_players; i++)
+    {
+        if (!Model_get_live_trail_bounds(model, i, &min_x, &max_x, &min_y, &max_y))
+            continue;
+        const int d = Segments_ray_distance(min_x, max_x, min_y, max_y, *cx, *cy, dx, dy);
+        if (d >= 0 && (best < 0 || d < best))
+            best = d;
+    }
+
+    if (best < 0 || Model_out_of_bounds(model, *cx + dx * best, *cy + dy * best))
+        return false;
+    *cx += dx * best;
+    *cy += dy * best;
+    return true;
+}
+
+bool Model_raycast_grid(const Model* model, int* cx, int* cy, const int direction)
+{
+    if (model->rows == NULL)
+        return false;
+
+    if (model->bitboard.kernels != NULL)
+    {
+        int dx, dy;
+        Model_get_relative_direction(direction, &dx, &dy);
+        const int distance = Bitboard_raycast(&model->bitboard, *cx, *cy, dx, dy);
+        if (distance < 0)
+            return false;
+        *cx += dx * distance;
+        *cy += dy * distance;
+        return true;
+    }
+
+    const Span* span;
+    switch (direction)
+    {
+    case DIRECTION_UP:
+        span = SpanList_last_before(&model->columns[*cx], *cy);
+        if (span == NULL)
+            return false;
+        *cy = span->max < *cy ? span->max : *cy;
+        return true;
+    case DIRECTION_DOWN:
+        span = SpanList_first_after(&model->columns[*cx], *cy);
+        if (span == NULL)
+            return false;
+        *cy = span->min > *cy ? span->min : *cy;
+        return true;
+    case DIRECTION_LEFT:
+        span = SpanList_last_before(&model->rows[*cy], *cx);
+        if (span == NULL)
+            return false;
+        *cx = span->max < *cx ? span->max : *cx;
+        return true;
+    case DIRECTION_RIGHT:
+        span = SpanList_first_after(&model->rows[*cy], *cx);
+        if (span == NULL)
+            return false;
+        *cx = span->min > *cx ? span->min : *cx;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Model_try_hit_raycast(const Model* model, const int x, const int y, const int direction, Wall* output,
+                           int* distance)
+{
+    *distance = -1;
+    if (model->width <= 0 || model->height <= 0)
+        return false;
+
     int cx = x;
     int cy = y;
 
@@ -199,32 +833,46 @@ bool Model_try_hit_raycast(const Model* model, const int x, const int y, const i
     if (cy >= model->height)
         cy = model->height - 1;
 
-    while (!Model_out_of_bounds(model, cx, cy))
+    // find the first occupied cell from (cx, cy) in the direction
+    const int start_x = cx;
+    const int start_y = cy;
+    bool hit = model->storage == MODEL_STORAGE_SEGMENTS
+                   ? Model_raycast_segments(model, &cx, &cy, direction)
+                   : Model_raycast_grid(model, &cx, &cy, direction);
+
+    // then the first obstacle of the map before it
+    if (model->map != NULL)
     {
-        if (Model_try_hit_walls(model, cx, cy, output))
+        int dx, dy;
+        Model_get_relative_direction(direction, &dx, &dy);
+        const int limit = hit ? abs(cx - start_x) + abs(cy - start_y) : -1;
+        const int obstacle = Map_raycast(model->map, start_x, start_y, dx, dy, limit);
+        if (obstacle >= 0)
         {
-            switch (direction)
-            {
-            case DIRECTION_UP:
-                *distance = y - cy;
-                break;
-            case DIRECTION_DOWN:
-                *distance = cy - y;
-                break;
-            case DIRECTION_LEFT:
-                *distance = x - cx;
-                break;
-            case DIRECTION_RIGHT:
-                *distance = cx - x;
-                break;
-            }
-            return true;
+            cx = start_x + dx * obstacle;
+            cy = start_y + dy * obstacle;
+            hit = true;
         }
-        cx += dx;
-        cy += dy;
     }
-    *distance = -1;
-    return false;
+    if (!hit)
+        return false;
+
+    switch (direction)
+    {
+    case DIRECTION_UP:
+        *distance = y - cy;
+        break;
+    case DIRECTION_DOWN:
+        *distance = cy - y;
+        break;
+    case DIRECTION_LEFT:
+        *distance = x - cx;
+        break;
+    case DIRECTION_RIGHT:
+        *distance = cx - x;
+        break;
+    }
+    return Model_try_hit_walls(model, cx, cy, output);
 }
 
 bool Model_change_direction(Model* model, const int index, const int direction)
@@ -240,49 +888,50 @@ bool Model_change_direction(Model* model, const int index, const int direction)
     if (direction == opposite)
         return false;
 
-    // add a wall in the direction of the player until it hits a wall
-    Wall wall;
-    int distance;
-    if (Model_try_hit_raycast(model, player->x, player->y, opposite, &wall, &distance))
-    {
-        debug_logf("[ADD] Wall %d %d %d %d", wall.x, wall.y, wall.direction, wall.length);
-        if (!Model_add_wall(model, player->x, player->y, current, distance, index))
-            return false;
-    }
+    // add a wall for the live trail, the new one starts at the player position
+    if (!Model_commit_player_wall(model, index))
+        return false;
 
+    Model_toggle_player(model, index);
     player->direction = direction;
+    Model_toggle_player(model, index);
+    Model_emit_player(model, EVENT_PLAYER_TURNED, index, 0);
     return true;
 }
 
-void Model_move_player(const Model* model, const int index, const int speed)
+void Model_move_player(Model* model, const int index, const int speed)
 {
     Player* player = &model->players[index];
-    int dx = 0;
-    int dy = 0;
+    player->moved = 0;
+    player->collision = 0;
+    if (speed <= 0)
+        return;
+    Model_toggle_player(model, index);
 
-    switch (player->direction)
-    {
-    case DIRECTION_UP:
-        dy = -speed;
-        break;
-    case DIRECTION_DOWN:
-        dy = speed;
-        break;
-    case DIRECTION_LEFT:
-        dx = -speed;
-        break;
-    case DIRECTION_RIGHT:
-        dx = speed;
-        break;
-    default: ;
-    }
+    int dx, dy;
+    Model_get_relative_direction(player->direction, &dx, &dy);
+
+    // the cell left behind belongs to the live trail, the cells crossed are marked once the collisions are resolved
+    Model_fill_wall(model, player->x, player->y, player->direction, 1, index);
 
-    player->x += dx;
-    player->y += dy;
+    player->x += dx * speed;
+    player->y += dy * speed;
+    player->trail_length += speed;
+    player->moved = speed;
+    Model_toggle_player(model, index);
 }
 
 void Model_place_player(const Model* self, Player* player, const int index)
 {
+    // the start positions of the map come first
+    if (self->map != NULL && index < self->map->num_spawns)
+    {
+        player->x = (int)self->map->spawns[index].x;
+        player->y = (int)self->map->spawns[index].y;
+        player->direction = (Direction)self->map->spawns[index].direction;
+        return;
+    }
+
     // 1. get the radius
     const int radius = self->width / 2 < self->height
                            ? self->width / 6
@@ -331,16 +980,41 @@ void Model_start(Model* self)
         return;
     }
 
+    // the game area is the map
+    if (self->map != NULL)
+    {
+        self->width = self->map->width;
+        self->height = self->map->height;
+    }
+
     // set the players with default values
     for (int i = 0; i < self->num_players; i++)
     {
         self->players[i].score = 0;
         self->players[i].state = PLAYER_STATE_ALIVE;
         Model_place_player(self, &self->players[i], i);
+        self->players[i].trail_x = self->players[i].x;
+        self->players[i].trail_y = self->players[i].y;
+        self->players[i].trail_length = 0;
+        self->players[i].moved = 0;
+        self->players[i].collision = 0;
+        self->players[i].respawn_tick = 0;
+    }
+    self->tick = 0;
+
+    if (self->width > MODEL_MAX_SIZE || self->height > MODEL_MAX_SIZE)
+    {
+        debug_log("Game area too large");
+        return;
     }
 
-    // set the walls with default values
+    // set the walls with default values, reusing the memory of the previous game
     Model_clear_walls(self);
+    if (self->storage == MODEL_STORAGE_GRID && !Model_allocate_grid(self))
+    {
+        debug_log("Failed to allocate grid");
+        return;
+    }
     debug_logf("Players: %d", self->num_players);
     debug_logf("Walls: %d", self->num_walls);
 
@@ -351,75 +1025,533 @@ void Model_start(Model* self)
             return;
         }
     // set the state to playing
-    self->state = GAME_STATE_PLAYING;
+    Model_set_state(self, GAME_STATE_PLAYING);
 }
 
-void Model_calculate_player_state(Model* self, const int index)
+int Model_evaluate_player(const Model* self, const int index)
 {
-    // check if the player is out of bounds
-    Player* player = &self->players[index];
-    if (Model_out_of_bounds(self, player->x, player->y))
+    const Player* player = &self->players[index];
+    if (player->moved <= 0)
+        return 0;
+
+    int dx, dy;
+    Model_get_relative_direction(player->direction, &dx, &dy);
+    const int x = player->x - dx * player->moved;
+    const int y = player->y - dy * player->moved;
+
+    // check if the player goes out of bounds
+    int steps = 0;
+    switch (player->direction)
     {
-        player->state = PLAYER_STATE_TO_DEATH;
-        debug_logf("[DEATH] Player %d is out of bounds at %d %d", index, player->x, player->y);
-        return;
+    case DIRECTION_UP:
+        steps = y + 1;
+        break;
+    case DIRECTION_DOWN:
+        steps = self->height - y;
+        break;
+    case DIRECTION_LEFT:
+        steps = x + 1;
+        break;
+    case DIRECTION_RIGHT:
+        steps = self->width - x;
+        break;
     }
+    const int collision = steps <= player->moved ? steps : 0;
 
-    // check if the player hit a wall
+    // check if the player hits a wall or a live trail before that
+    const int limit = collision > 0 ? collision - 1 : player->moved;
     Wall wall;
-    if (Model_try_hit_walls(self, player->x, player->y, &wall))
-    {
-        player->state = PLAYER_STATE_TO_DEATH;
-        debug_logf("[DEATH] Player %d hit a wall at %d %d", index, player->x, player->y);
+    int distance;
+    if (limit > 0 && Model_try_hit_raycast(self, x + dx, y + dy, player->direction, &wall, &distance)
+        && distance < limit)
+        return distance + 1;
+    return collision;
+}
+
+void Model_apply_player_state(Model* self, const int index, const int collision)
+{
+    Player* player = &self->players[index];
+    player->collision = collision;
+    if (collision <= 0)
         return;
+
+    Model_toggle_player(self, index);
+    player->state = PLAYER_STATE_TO_DEATH;
+    Model_toggle_player(self, index);
+
+    int dx, dy;
+    Model_get_relative_direction(player->direction, &dx, &dy);
+    const int x = player->x + dx * (collision - player->moved);
+    const int y = player->y + dy * (collision - player->moved);
+    if (Model_out_of_bounds(self, x, y))
+        debug_logf("[DEATH] Player %d is out of bounds at %d %d", index, x, y);
+    else
+        debug_logf("[DEATH] Player %d hit a wall of player %d at %d %d", index, Model_get_cell_owner(self, x, y), x, y);
+}
+
+void Model_calculate_player_state(Model* self, const int index)
+{
+    Model_apply_player_state(self, index, Model_evaluate_player(self, index));
+}
+
+Sweep Model_get_sweep(const Model* self, const int index)
+{
+    // the move of the player, up to its collision
+    const Player* player = &self->players[index];
+    Sweep sweep;
+    Model_get_relative_direction(player->direction, &sweep.dx, &sweep.dy);
+    sweep.x = player->x - sweep.dx * player->moved;
+    sweep.y = player->y - sweep.dy * player->moved;
+    sweep.reach = player->collision > 0 ? player->collision : player->moved;
+    return sweep;
+}
+
+void Model_resolve_collisions(Model* self)
+{
+    // hash the moves by the tiles they cross
+    SweepHash* hash = &self->sweeps;
+    SweepHash_clear(hash);
+    for (int i = 0; i < self->num_players; i++)
+    {
+        if (self->players[i].moved <= 0)
+            continue;
+        const Sweep sweep = Model_get_sweep(self, i);
+        if (!SweepHash_add(hash, &sweep, i))
+            debug_log("Failed to add sweep");
+    }
+    if (!SweepHash_build(hash))
+    {
+        debug_log("Failed to build sweep hash");
+        SweepHash_clear(hash);
     }
 
-    // check if the player hit another player
-    int output;
-    if (Model_try_hit_players(self, index, &output))
+    // first contact of each move with the cells the other moves entered before or at the same step
+    for (int s = 0; s < hash->num_sweeps; s++)
     {
-        Player* other = &self->players[output];
+        const int* candidates;
+        const int num_candidates = SweepHash_query(hash, s, &candidates);
+        for (int c = 0; c < num_candidates; c++)
+        {
+            const int other = candidates[c];
+            Collision collision = {0, hash->ids[s], hash->ids[other], 0};
+            if (Sweep_first_contact(&hash->sweeps[s], &hash->sweeps[other], hash->sweeps[other].reach,
+                                    &collision.step, &collision.other_step)
+                && !CollisionQueue_push(&self->collisions, collision))
+                debug_log("Failed to push collision");
+        }
+    }
+
+    // in step order, a contact only counts if the other player reached the cell
+    Collision collision;
+    while (CollisionQueue_pop(&self->collisions, &collision))
+    {
+        Player* player = &self->players[collision.victim];
+        if (player->collision > 0 && player->collision <= collision.step)
+            continue;
+
+        const Sweep other = Model_get_sweep(self, collision.other);
+        if (other.reach < collision.other_step)
+        {
+            // the other player stopped before, look for a contact with the part of its move it crossed
+            const Sweep sweep = Model_get_sweep(self, collision.victim);
+            if (Sweep_first_contact(&sweep, &other, other.reach, &collision.step, &collision.other_step)
+                && !CollisionQueue_push(&self->collisions, collision))
+                debug_log("Failed to push collision");
+            continue;
+        }
+
+        player->collision = collision.step;
+        Model_toggle_player(self, collision.victim);
         player->state = PLAYER_STATE_TO_DEATH;
-        other->state = PLAYER_STATE_TO_DEATH;
-        debug_logf("[DEATH] Player %d hit player %d at %d %d", index, output, player->x, player->y);
-        return;
+        Model_toggle_player(self, collision.victim);
+        debug_logf("[DEATH] Player %d hit player %d at %d %d", collision.victim, collision.other,
+                   other.x + other.dx * collision.other_step, other.y + other.dy * collision.other_step);
     }
 
-    // check if the player hit a player wall
-    int distance;
+    // stop the players on their collision cell, the cells crossed before belong to the live trail
     for (int i = 0; i < self->num_players; i++)
     {
-        if (i == index) continue;
-        const Player other = self->players[i];
-        if (other.state != PLAYER_STATE_ALIVE) continue;
-        Model_get_player_wall(self, i, &wall, &distance);
-        wall.direction = Model_get_opposite_direction(other.direction);
-        wall.length = distance;
-        if (distance > 0 && Model_hit_wall(&wall, player->x, player->y))
+        Player* player = &self->players[i];
+        if (player->moved <= 0)
+            continue;
+        const Sweep sweep = Model_get_sweep(self, i);
+        const int back = player->moved - sweep.reach;
+        Model_toggle_player(self, i);
+        player->x -= sweep.dx * back;
+        player->y -= sweep.dy * back;
+        player->trail_length -= back;
+        Model_toggle_player(self, i);
+        if (sweep.reach > 1)
+            Model_fill_wall(self, player->x - sweep.dx, player->y - sweep.dy, player->direction, sweep.reach - 1, i);
+        player->moved = 0;
+    }
+}
+
+void Model_get_player_wall(const Model* self, const int index, Wall* output, int* distance)
+{
+    const Player* player = &self->players[index];
+    output->x = player->x;
+    output->y = player->y;
+    output->direction = player->direction;
+    output->length = player->trail_length;
+    output->player = index;
+    *distance = player->trail_length;
+}
+
+bool Model_commit_player_wall(Model* self, const int index)
+{
+    Player* player = &self->players[index];
+    if (player->trail_length > 0)
+    {
+        debug_logf("[ADD] Wall %d %d %d %d", player->x, player->y, player->direction, player->trail_length);
+        if (!Model_add_wall(self, player->x, player->y, player->direction, player->trail_length, index))
+            return false;
+    }
+
+    Model_toggle_player(self, index);
+    player->trail_x = player->x;
+    player->trail_y = player->y;
+    player->trail_length = 0;
+    Model_toggle_player(self, index);
+    return true;
+}
+
+bool Model_remove_wall(Model* self, const int index)
+{
+    const Wall wall = Model_get_wall(self, index);
+    if (wall.length == 0)
+        return true;
+    if (!Model_log_wall(self, index))
+        return false;
+
+    if (self->storage == MODEL_STORAGE_SEGMENTS)
+        Segments_remove(&self->segments, index);
+    else if (self->rows != NULL)
+    {
+        // free the cells of the wall, no other wall covers them
+        int dx, dy;
+        Model_get_relative_direction(Model_get_opposite_direction(wall.direction), &dx, &dy);
+        int cx = wall.x;
+        int cy = wall.y;
+        for (int i = 0; i < wall.length; i++)
         {
-            player->state = PLAYER_STATE_TO_DEATH;
-            debug_logf("[DEATH] Player %d hit player %d wall at %d %d", index, i, player->x, player->y);
-            return;
+            if (!Model_set_cell(self, cx, cy, CELL_EMPTY))
+                return false;
+            cx += dx;
+            cy += dy;
         }
     }
+
+    Model_emit_wall(self, EVENT_WALL_REMOVED, index);
+    self->checksum ^= Model_hash_wall(&self->walls[index]);
+    self->walls[index].length = 0;
+    self->num_removed_walls++;
+    return true;
 }
 
+void Model_compact_walls(Model* self)
+{
+    // move the remaining walls down in order, rebuilding the list of walls of each player
+    for (int i = 0; i < self->num_players; i++)
+        self->players[i].last_wall = -1;
 
-void Model_get_player_wall(const Model* self, const int index, Wall* output, int* distance)
+    int count = 0;
+    for (int i = 0; i < self->num_walls; i++)
+    {
+        if (self->walls[i].length == 0)
+            continue;
+        const int player = self->walls[i].info >> 2;
+        if (!Model_log_wall(self, count))
+            debug_log("Failed to log wall");
+        self->walls[count] = self->walls[i];
+        self->links[count].previous = self->players[player].last_wall;
+        self->links[count].tick = self->links[i].tick;
+        if (self->storage == MODEL_STORAGE_SEGMENTS)
+        {
+            self->segments.min_x[count] = self->segments.min_x[i];
+            self->segments.max_x[count] = self->segments.max_x[i];
+            self->segments.min_y[count] = self->segments.min_y[i];
+            self->segments.max_y[count] = self->segments.max_y[i];
+            self->segments.owner[count] = self->segments.owner[i];
+        }
+        self->players[player].last_wall = count;
+        count++;
+    }
+
+    if (self->storage == MODEL_STORAGE_SEGMENTS)
+        self->segments.num_segments = count;
+    self->num_walls = count;
+    self->num_removed_walls = 0;
+    self->oldest_wall = 0;
+    Model_emit(self, EVENT_WALLS_COMPACTED, -1, -1, 0, 0, 0, count);
+}
+
+unsigned long long Model_random(Model* self)
 {
-    const Player* player = &self->players[index];
-    Model_try_hit_raycast(self, player->x, player->y, Model_get_opposite_direction(player->direction), output,
-                          distance);
+    // splitmix64
+    return Model_mix(self->random += 0x9e3779b97f4a7c15ULL);
+}
+
+bool Model_respawn_player(Model* self, const int index)
+{
+    for (int attempt = 0; attempt < MODEL_SPAWN_ATTEMPTS; attempt++)
+    {
+        // a free cell, that is not the position of another player
+        const int x = (int)(Model_random(self) % (unsigned long long)self->width);
+        const int y = (int)(Model_random(self) % (unsigned long long)self->height);
+        if (Model_get_cell_owner(self, x, y) >= 0)
+            continue;
+        bool taken = false;
+        for (int i = 0; i < self->num_players && !taken; i++)
+            taken = self->players[i].state == PLAYER_STATE_ALIVE && Model_hit_player(&self->players[i], x, y);
+        if (taken)
+            continue;
+
+        // facing the longest free run
+        Direction best_direction = DIRECTION_UP;
+        int best_distance = -1;
+        for (Direction direction = DIRECTION_UP; direction <= DIRECTION_RIGHT; direction++)
+        {
+            Wall wall;
+            int distance;
+            if (!Model_try_hit_raycast(self, x, y, direction, &wall, &distance))
+                distance = direction == DIRECTION_UP ? y + 1
+                         : direction == DIRECTION_DOWN ? self->height - y
+                         : direction == DIRECTION_LEFT ? x + 1
+                         : self->width - x;
+            if (distance > best_distance)
+            {
+                best_distance = distance;
+                best_direction = direction;
+            }
+        }
+        if (best_distance <= MODEL_SPAWN_CLEARANCE)
+            continue;
+
+        // the live trail starts with the spawn cell, there is no start wall
+        Player* player = &self->players[index];
+        int dx, dy;
+        Model_get_relative_direction(best_direction, &dx, &dy);
+        Model_toggle_player(self, index);
+        player->x = x;
+        player->y = y;
+        player->direction = best_direction;
+        player->state = PLAYER_STATE_ALIVE;
+        player->trail_x = x - dx;
+        player->trail_y = y - dy;
+        player->trail_length = 1;
+        player->last_wall = -1;
+        player->moved = 0;
+        player->collision = 0;
+        Model_toggle_player(self, index);
+        Model_emit_player(self, EVENT_PLAYER_SPAWNED, index, 0);
+        debug_logf("[SPAWN] Player %d at %d %d", index, x, y);
+        return true;
+    }
+    return false;
+}
+
+bool Model_kill_player(Model* self, const int index)
+{
+    Player* player = &self->players[index];
+    Model_toggle_player(self, index);
+    player->state = PLAYER_STATE_DEAD;
+    Model_toggle_player(self, index);
+    if (self->mode != GAME_MODE_ENDLESS)
+    {
+        Model_emit_player(self, EVENT_PLAYER_DIED, index, 0);
+        return Model_commit_player_wall(self, index);
+    }
+
+    // the crashed head is left out of the trail when its cell already belongs to a wall, so that each cell
+    // belongs to a single wall and removing a wall frees all its cells
+    if (player->trail_length > 0 && Model_get_cell_owner(self, player->x, player->y) >= 0)
+    {
+        int dx, dy;
+        Model_get_relative_direction(player->direction, &dx, &dy);
+        Model_toggle_player(self, index);
+        player->x -= dx;
+        player->y -= dy;
+        player->trail_length--;
+        Model_toggle_player(self, index);
+    }
+    Model_emit_player(self, EVENT_PLAYER_DIED, index, 0);
+    const bool committed = Model_commit_player_wall(self, index);
+
+    // the walls of the player expire with it
+    for (int i = player->last_wall; i >= 0 && self->walls[i].length > 0; i = self->links[i].previous)
+        if (!Model_remove_wall(self, i))
+            debug_log("Failed to remove wall");
+    player->last_wall = -1;
+    player->respawn_tick = self->tick + self->respawn_delay;
+    return committed;
+}
+
+void Model_advance(Model* self)
+{
+    self->tick++;
+    if (self->mode != GAME_MODE_ENDLESS)
+        return;
+
+    // the walls are in the order they were added, the expired ones are at the front
+    if (self->trail_lifetime > 0)
+        for (; self->oldest_wall < self->num_walls
+               && self->links[self->oldest_wall].tick + self->trail_lifetime <= self->tick; self->oldest_wall++)
+            if (!Model_remove_wall(self, self->oldest_wall))
+                debug_log("Failed to remove wall");
+
+    if (self->num_removed_walls >= MODEL_MIN_COMPACT_WALLS && 2 * self->num_removed_walls >= self->num_walls)
+        Model_compact_walls(self);
+
+    for (int i = 0; i < self->num_players; i++)
+        if (self->players[i].state == PLAYER_STATE_DEAD && self->players[i].respawn_tick <= self->tick)
+            Model_respawn_player(self, i);
+}
+
+bool Model_snapshot(Model* self, ModelSnapshot* output)
+{
+    // the players all change at each update, they are copied
+    ModelLog* log = &self->log;
+    if (!Model_reserve((void**)&log->players, &log->allocated_players, log->num_players + self->num_players,
+                       sizeof(Player)))
+        return false;
+    memcpy(&log->players[log->num_players], self->players, self->num_players * sizeof(Player));
+
+    output->depth = log->num_snapshots;
+    output->num_cell_changes = log->num_cells;
+    output->num_wall_changes = log->num_walls;
+    output->players = log->num_players;
+    output->num_players = self->num_players;
+    output->num_walls = self->num_walls;
+    output->num_removed_walls = self->num_removed_walls;
+    output->oldest_wall = self->oldest_wall;
+    output->tick = self->tick;
+    output->random = self->random;
+    output->checksum = self->checksum;
+    output->state = self->state;
+    log->num_players += self->num_players;
+    log->num_snapshots++;
+    if (self->num_walls > log->max_walls)
+        log->max_walls = self->num_walls;
+    return true;
+}
+
+bool Model_restore(Model* self, const ModelSnapshot* snapshot)
+{
+    ModelLog* log = &self->log;
+    if (snapshot->depth >= log->num_snapshots || snapshot->num_players > self->allocated_players)
+    {
+        debug_log("Snapshot already released");
+        return false;
+    }
+
+    // undo the changes of the walls, newest first, their segments follow
+    while (log->num_walls > snapshot->num_wall_changes)
+    {
+        const WallChange* change = &log->walls[--log->num_walls];
+        self->walls[change->index] = change->wall;
+        if (self->links != NULL)
+            self->links[change->index] = change->link;
+        if (self->storage == MODEL_STORAGE_SEGMENTS)
+        {
+            const Wall wall = Model_get_wall(self, change->index);
+            if (wall.length == 0)
+                Segments_remove(&self->segments, change->index);
+            else
+            {
+                Segments* segments = &self->segments;
+                Model_get_wall_bounds(wall.x, wall.y, wall.direction, wall.length,
+                                      &segments->min_x[change->index], &segments->max_x[change->index],
+                                      &segments->min_y[change->index], &segments->max_y[change->index]);
+                segments->owner[change->index] = wall.player;
+            }
+        }
+    }
+
+    // undo the changes of the cells, without logging them
+    log->num_snapshots = 0;
+    bool restored = true;
+    while (log->num_cells > snapshot->num_cell_changes)
+    {
+        const CellChange* change = &log->cells[--log->num_cells];
+        restored = Model_set_cell(self, change->x, change->y, change->cell) && restored;
+    }
+
+    // the walls added since are dropped
+    self->num_walls = snapshot->num_walls;
+    if (self->storage == MODEL_STORAGE_SEGMENTS)
+        self->segments.num_segments = snapshot->num_walls;
+    self->num_removed_walls = snapshot->num_removed_walls;
+    self->oldest_wall = snapshot->oldest_wall;
+    self->tick = snapshot->tick;
+    self->random = snapshot->random;
+    self->checksum = snapshot->checksum;
+    self->state = snapshot->state;
+    self->num_players = snapshot->num_players;
+    memcpy(self->players, &log->players[snapshot->players], snapshot->num_players * sizeof(Player));
+
+    // the snapshot is kept, the ones taken after it are dropped
+    log->num_players = snapshot->players + snapshot->num_players;
+    log->num_snapshots = snapshot->depth + 1;
+    Model_emit(self, EVENT_RESTORED, -1, -1, 0, 0, 0, 0);
+    if (!restored)
+        debug_log("Failed to restore cells");
+    return restored;
+}
+
+void Model_release(Model* self, const ModelSnapshot* snapshot)
+{
+    ModelLog* log = &self->log;
+    if (snapshot->depth >= log->num_snapshots)
+        return;
+
+    // the changes are kept for the snapshots taken before
+    log->num_snapshots = snapshot->depth;
+    if (log->num_snapshots == 0)
+    {
+        log->num_cells = 0;
+        log->num_walls = 0;
+        log->num_players = 0;
+        log->max_walls = 0;
+    }
+}
+
+unsigned long long Model_get_checksum(const Model* self)
+{
+    return Model_mix(self->checksum ^ Model_mix((unsigned long long)(unsigned int)self->tick) ^ self->random);
+}
+
+void Model_add_score(Model* self, const int index, const int points)
+{
+    self->players[index].score += points;
+    Model_emit_player(self, EVENT_SCORE_CHANGED, index, self->players[index].score);
+}
+
+void Model_reward_survivors(Model* self)
+{
+    for (int i = 0; i < self->num_players; i++)
+        if (self->players[i].state == PLAYER_STATE_ALIVE)
+            self->players[i].score++;
+}
+
+unsigned long long Model_get_event_cursor(const Model* self)
+{
+    return EventRing_get_head(&self->events);
+}
+
+EventReadResult Model_read_event(const Model* self, unsigned long long* cursor, Event* output)
+{
+    return EventRing_read(&self->events, cursor, output);
 }
 
 void Model_cancel(Model* self)
 {
-    self->state = GAME_STATE_MENU;
+    Model_set_state(self, GAME_STATE_MENU);
 }
 
 void Model_game_over(Model* self)
 {
-    self->state = GAME_STATE_GAME_OVER;
+    Model_set_state(self, GAME_STATE_GAME_OVER);
 }
 
 void Model_remove_player(Model* self, const int index)
@@ -429,21 +1561,12 @@ void Model_remove_player(Model* self, const int index)
     for (int i = index; i < self->num_players - 1; i++)
         self->players[i] = self->players[i + 1];
     self->num_players--;
-
-    // use allocated_player to free the memory
-    int allocated_player = self->num_players + PLAYER_CHUNK - self->num_players % PLAYER_CHUNK;
-    if (allocated_player != self->allocated_players)
-    {
-        Player* tmp = realloc(self->players, allocated_player * sizeof(Player));
-        if (tmp == NULL)
-            return;
-        self->players = tmp;
-        self->allocated_players = allocated_player;
-    }
+    Model_rehash(self);
+    Model_emit(self, EVENT_PLAYER_REMOVED, index, -1, 0, 0, 0, 0);
 }
 
 void Model_reset(Model* self)
 {
     Model_clear_walls(self);
-    self->state = GAME_STATE_MENU;
+    Model_set_state(self, GAME_STATE_MENU);
 }
@@ -2,6 +2,15 @@
 #define MODEL_H
 #include <stdbool.h>
 
+#include "arena.h"
+#include "bitboard.h"
+#include "collision.h"
+#include "event_ring.h"
+#include "map.h"
+#include "segments.h"
+#include "span_list.h"
+#include "tile_grid.h"
+
 typedef struct Tron Tron; // Forward declaration
 
 typedef int PlayerState;
@@ -19,16 +28,32 @@ enum {
     DIRECTION_RIGHT
 };
 
-#define PLAYER_CHUNK 4
+#define MODEL_INITIAL_PLAYERS 4
+#define MODEL_MAX_PLAYERS 16383 // players must fit in the 14 bits of a packed wall
+#define MODEL_MAX_SIZE (1 << 20) // the rows and the columns of the raycast index are allocated for the whole game
+#define MODEL_OBSTACLE MODEL_MAX_PLAYERS // owner of the obstacles of the map, no player has this index
 typedef struct Player {
     int x;
     int y;
     Direction direction;
     int score;
     PlayerState state;
+    // Last committed cell of the trail, the live segment starts right after it
+    int trail_x;
+    int trail_y;
+    // Length of the live segment, from the trail start to the player position
+    int trail_length;
+    // Index of the last wall of the player in the model, -1 if none
+    int last_wall;
+    // Cells moved during the current update, until the collisions are resolved
+    int moved;
+    // Step of the current move at which the player collides, 0 if none
+    int collision;
+    // Update at which a dead player respawns (endless mode)
+    int respawn_tick;
 } Player;
 
-#define WALL_CHUNK 4
+#define MODEL_INITIAL_WALLS 256
 typedef struct Wall {
     int x;
     int y;
@@ -37,6 +62,66 @@ typedef struct Wall {
     int player;
 } Wall;
 
+#define MODEL_MIN_COMPACT_WALLS 256 // removed walls are compacted once they are half of the walls, and at least this many
+#define MODEL_SPAWN_ATTEMPTS 16 // random cells tried at each update to respawn a player
+#define MODEL_SPAWN_CLEARANCE 4 // free cells needed in front of a respawned player
+#define MODEL_MAX_WALL_LENGTH 65535 // longer walls are split, their length must fit in the 16 bits of a packed wall
+// Age and owner list of a wall (endless mode)
+typedef struct WallLink {
+    int previous; // previous wall of the same player, -1 if none
+    int tick; // update at which the wall was added
+} WallLink;
+
+// Wall as stored in the model (12 bytes)
+typedef struct PackedWall {
+    unsigned int x;
+    unsigned int y;
+    unsigned short length;
+    unsigned short info; // direction in the 2 low bits, player in the 14 high bits
+} PackedWall;
+
+typedef int ModelStorage;
+enum {
+    MODEL_STORAGE_GRID, // occupancy grid and row/column index
+    MODEL_STORAGE_SEGMENTS // walls scanned as normalized segments, no per-cell memory
+};
+
+// Cell of the occupancy grid before a change
+typedef struct CellChange {
+    int x;
+    int y;
+    Cell cell;
+} CellChange;
+
+// Wall before a change
+typedef struct WallChange {
+    int index;
+    PackedWall wall;
+    WallLink link;
+} WallChange;
+
+#define MODEL_LOG_INITIAL_CAPACITY 256
+// Undo log of the model, recorded while a snapshot is kept
+typedef struct ModelLog {
+    CellChange *cells;
+    int num_cells;
+    int allocated_cells;
+    WallChange *walls;
+    int num_walls;
+    int allocated_walls;
+    Player *players; // copies of the players at each snapshot
+    int num_players;
+    int allocated_players;
+    int num_snapshots;
+    int max_walls; // walls below this index belong to a snapshot, even once compacted and added again
+} ModelLog;
+
+typedef int GameMode;
+enum {
+    GAME_MODE_CLASSIC, // the game is over when a single player is alive
+    GAME_MODE_ENDLESS // trails expire, dead players respawn and the game never ends
+};
+
 typedef int GameState;
 enum {
     GAME_STATE_MENU,
@@ -44,6 +129,22 @@ enum {
     GAME_STATE_GAME_OVER
 };
 
+// Point to roll the model back to, see Model_snapshot
+typedef struct ModelSnapshot {
+    int depth;
+    int num_cell_changes;
+    int num_wall_changes;
+    int players; // index of the copy of the players in the log
+    int num_players;
+    int num_walls;
+    int num_removed_walls;
+    int oldest_wall;
+    int tick;
+    unsigned long long random;
+    unsigned long long checksum;
+    GameState state;
+} ModelSnapshot;
+
 typedef struct Model {
     Tron *game;
 
@@ -51,16 +152,74 @@ typedef struct Model {
     int width;
     int height;
 
+    // Part of the game area where the walls and the cells are kept, the whole area if not windowed
+    bool windowed;
+    int window_min_x;
+    int window_max_x;
+    int window_min_y;
+    int window_max_y;
+
     // List of players
     Player *players;
     int num_players;
     int allocated_players;
 
-    // List of walls
-    Wall *walls;
+    // Memory of the current game: walls, occupancy grid, index and segments
+    Arena arena;
+
+    // List of walls, clipped to the game area, in the order they were added
+    PackedWall *walls;
     int num_walls;
     int allocated_walls;
 
+    // Walls removed in endless mode keep a length of 0 until the walls are compacted
+    WallLink *links;
+    int num_removed_walls;
+    int oldest_wall; // first wall not expired by age
+
+    // Storage used for the hit tests and the raycasts
+    ModelStorage storage;
+
+    // Static obstacles and start positions, NULL for an empty game area
+    const Map *map;
+
+    // Occupancy grid, kept in sync with the walls, its tiles are allocated when a trail first enters them
+    TileGrid grid;
+
+    // Occupancy of the game areas up to BITBOARD_MAX_SIZE cells, used instead of the index (kernels NULL otherwise)
+    Bitboard bitboard;
+
+    // Occupied cells of each row and each column, as sorted spans (raycast index)
+    SpanList *rows;
+    int num_rows;
+    SpanList *columns;
+    int num_columns;
+
+    // Walls as normalized segments (segments storage)
+    Segments segments;
+
+    // Moves of the current update and the collisions between them, reused from one update to the next
+    SweepHash sweeps;
+    CollisionQueue collisions;
+
+    // Game mode, and the options of the endless mode
+    GameMode mode;
+    int trail_lifetime; // updates a wall lasts, 0 for no limit
+    int respawn_delay; // updates before a dead player respawns
+
+    // Changes to undo when restoring a snapshot
+    ModelLog log;
+
+    // Updates since the start of the game, and state of the random generator of the spawn positions
+    int tick;
+    unsigned long long random;
+
+    // Xor of the hashes of the walls and of the players, updated as they change
+    unsigned long long checksum;
+
+    // Changes published for the vues and the other consumers, they are not undone by the snapshots
+    EventRing events;
+
     // Game state
     GameState state;
 } Model;
@@ -73,6 +232,51 @@ typedef struct Model {
  */
 void Model_init(Model *self, int width, int height);
 
+/**
+ * @brief Set the storage used for the hit tests and the raycasts
+ * @param self The model
+ * @param storage The storage
+ * @note The storage can only be changed when the game is not playing
+ */
+void Model_set_storage(Model *self, const ModelStorage storage);
+
+/**
+ * @brief Only keep the walls and the cells of a part of the game area
+ * @param self The model
+ * @param min_x The first column of the window
+ * @param max_x The last column of the window
+ * @param min_y The first row of the window
+ * @param max_y The last row of the window
+ * @note The walls are clipped to the window, so the hit tests and the raycasts only see the walls inside it. The
+ * players are still moved over the whole game area. The window can only be changed when the game is not playing
+ */
+void Model_set_window(Model *self, const int min_x, const int max_x, const int min_y, const int max_y);
+
+/**
+ * @brief Keep the walls and the cells of the whole game area
+ * @param self The model
+ */
+void Model_clear_window(Model *self);
+
+/**
+ * @brief Set the map of the next games
+ * @param self The model
+ * @param map The map, that must stay open while it is used, NULL for an empty game area
+ * @note The game area takes the size of the map. Its obstacles are read in place by the hit tests and the raycasts,
+ * nothing is copied when a game starts. The map can only be changed when the game is not playing
+ */
+void Model_set_map(Model *self, const Map *map);
+
+/**
+ * @brief Set the game mode
+ * @param self The model
+ * @param mode The game mode
+ * @param trail_lifetime The number of updates a wall lasts in endless mode, 0 for no limit
+ * @param respawn_delay The number of updates before a dead player respawns in endless mode
+ * @note The mode can only be changed when the game is not playing
+ */
+void Model_set_mode(Model *self, const GameMode mode, const int trail_lifetime, const int respawn_delay);
+
 /**
  * @brief Add a player to the model
  * @param self The model
@@ -90,10 +294,21 @@ bool Model_add_player(Model *self, const int x, const int y, const int direction
  * @param y The y position of the wall
  * @param direction The direction of the wall
  * @param length The length of the wall
+ * @param player The owner of the wall
  * @return True if the wall was added, false otherwise
+ * @note The wall is clipped to the game area, split if longer than MODEL_MAX_WALL_LENGTH, and merged into the last
+ * wall of the player when they are collinear and touching
  */
 bool Model_add_wall(Model *self, const int x, const int y, const int direction, const int length, const int player);
 
+/**
+ * @brief Get a wall of the model
+ * @param self The model
+ * @param index The index of the wall
+ * @return The unpacked wall, with a length of 0 if it was removed
+ */
+Wall Model_get_wall(const Model *self, const int index);
+
 /**
  * @brief Destroy the model
  * @param self The model
@@ -116,13 +331,48 @@ Direction Model_get_opposite_direction(const Direction direction);
  */
 bool Model_hit_wall(const Wall* wall, const int x, const int y);
 
+/**
+ * @brief Get the owner of a cell of the occupancy grid
+ * @param model The model
+ * @param x The x position
+ * @param y The y position
+ * @return The index of the player owning the cell, MODEL_OBSTACLE for an obstacle of the map, -1 if the cell is
+ * empty or out of bounds
+ */
+int Model_get_cell_owner(const Model* model, const int x, const int y);
+
+/**
+ * @brief Get the cells covered by a wall as a box
+ * @param x The x position of the wall
+ * @param y The y position of the wall
+ * @param direction The direction of the wall
+ * @param length The length of the wall
+ * @param min_x The output first column
+ * @param max_x The output last column
+ * @param min_y The output first row
+ * @param max_y The output last row
+ */
+void Model_get_wall_bounds(const int x, const int y, const Direction direction, const int length,
+                           int *min_x, int *max_x, int *min_y, int *max_y);
+
+/**
+ * @brief Get the free neighbors of a cell
+ * @param model The model
+ * @param x The x position
+ * @param y The y position
+ * @return A mask with the bit d set when the neighbor in the direction d is free and in the game area
+ * @note On the small game areas of the grid storage, this is a few shifts of a row and a column of the bitboard
+ */
+int Model_get_free_neighbors(const Model* model, const int x, const int y);
+
 /**
  * @brief Try to hit a wall
  * @param model The model
  * @param x The x position
  * @param y The y position
- * @param output The output wall
+ * @param output The output wall (the cell that was hit, as a wall of length 1)
  * @return True if the point hit a wall, false otherwise
+ * @note This is a single lookup in the tiles of the occupancy grid, or a vectorized scan of the segments
  */
 bool Model_try_hit_walls(const Model* model, const int x, const int y, Wall* output);
 
@@ -161,6 +411,7 @@ bool Model_out_of_bounds(const Model* model, const int x, const int y);
  * @param output The output wall
  * @param distance The distance to the wall
  * @return True if the raycast hit a wall, false otherwise
+ * @note This is a binary search in the row or column index, or a vectorized scan of the segments
  */
 bool Model_try_hit_raycast(const Model* model, const int x, const int y, const int direction, Wall* output, int* distance);
 
@@ -179,8 +430,10 @@ bool Model_change_direction(Model* model, const int index, const int direction);
  * @param model The model
  * @param index The player index
  * @param speed Amount of movement
+ * @note The cell left behind is marked as the live trail of the player, the cells crossed are checked by
+ * Model_calculate_player_state and Model_resolve_collisions before they are marked
  */
-void Model_move_player(const Model* model, const int index, const int speed);
+void Model_move_player(Model* model, const int index, const int speed);
 
 /**
  * @brief Start the game
@@ -200,23 +453,147 @@ void Model_cancel(Model *self);
  */
 void Model_game_over(Model *self);
 
+/**
+ * @brief Find the first cell of the move of a player that is out of bounds or already occupied
+ * @param self The model
+ * @param index The index of the player
+ * @return The step of the move at which the player collides, 0 if none
+ * @note This only reads the model, the players can be evaluated in parallel once they all moved
+ */
+int Model_evaluate_player(const Model *self, const int index);
+
+/**
+ * @brief Apply the collision found by Model_evaluate_player
+ * @param self The model
+ * @param index The index of the player
+ * @param collision The step of the move at which the player collides, 0 if none
+ */
+void Model_apply_player_state(Model *self, const int index, const int collision);
+
 /**
  * @brief Calculate the player state
  * @param self The model
  * @param index The index of the player
+ * @note Finds the first cell of the move that is out of bounds or already occupied, with a single raycast
  */
 void Model_calculate_player_state(Model *self, const int index);
 
+/**
+ * @brief Resolve the collisions between the moves of the players
+ * @param self The model
+ * @note Only the moves sharing a tile of the spatial hash are tested. Contacts are processed in step order, a player
+ * that collides stops on the contact cell. Must be called once all the players moved and their state was calculated
+ */
+void Model_resolve_collisions(Model *self);
+
 
 /**
  * @brief Get the player wall
  * @param self The model
  * @param index The index of the player
- * @param output The output wall
- * @param distance The distance to the wall
+ * @param output The output wall (the live trail segment, ending at the player position)
+ * @param distance The length of the live trail segment
  */
 void Model_get_player_wall(const Model *self, const int index, Wall *output, int *distance);
 
+/**
+ * @brief Kill a player, committing its live trail
+ * @param self The model
+ * @param index The index of the player
+ * @return True if the trail was committed, false otherwise
+ * @note In endless mode the walls of the player are removed and its respawn is scheduled
+ */
+bool Model_kill_player(Model *self, const int index);
+
+/**
+ * @brief Advance the game by one update
+ * @param self The model
+ * @note In endless mode, this removes the walls older than the trail lifetime and respawns the dead players. The
+ * expired walls are dropped from the front of the list, the walls of dead players are compacted later, so the memory
+ * and the cost of an update stay flat however long the game lasts
+ */
+void Model_advance(Model *self);
+
+/**
+ * @brief Commit the live trail of a player as a wall
+ * @param self The model
+ * @param index The index of the player
+ * @return True if the wall was added (or there was nothing to add), false otherwise
+ */
+bool Model_commit_player_wall(Model *self, const int index);
+
+/**
+ * @brief Get the checksum of the game
+ * @param self The model
+ * @return A 64-bit hash of the walls, the players, the update number and the random generator
+ * @note The hash is maintained incrementally as the walls and the players change, two games with the same checksum
+ * are the same game with a very high probability, whatever their storage
+ */
+unsigned long long Model_get_checksum(const Model *self);
+
+/**
+ * @brief Add points to the score of a player
+ * @param self The model
+ * @param index The index of the player
+ * @param points The points to add
+ */
+void Model_add_score(Model *self, const int index, const int points);
+
+/**
+ * @brief Add the point of the update to the score of each alive player
+ * @param self The model
+ * @note No event is published: all the alive players score at each update, their events would fill the ring of the
+ * events in a few updates of a large game. The consumers read the scores from the players
+ */
+void Model_reward_survivors(Model *self);
+
+/**
+ * @brief Get the cursor of a new consumer of the events
+ * @param self The model
+ * @return The cursor, that reads the events published from now on
+ */
+unsigned long long Model_get_event_cursor(const Model *self);
+
+/**
+ * @brief Read the next event of a consumer
+ * @param self The model
+ * @param cursor The cursor of the consumer
+ * @param output The output event
+ * @return The result of the read
+ * @note A consumer reads the whole model once, then only the events: its work is proportional to what changed. It
+ * reads the whole model again on an overrun, and on the events that change many walls or the indices (cleared,
+ * compacted, restored, player removed)
+ */
+EventReadResult Model_read_event(const Model *self, unsigned long long *cursor, Event *output);
+
+/**
+ * @brief Take a snapshot of the game, to restore it later
+ * @param self The model
+ * @param output The output snapshot
+ * @return True if the snapshot was taken, false otherwise
+ * @note While a snapshot is kept, the model logs the cells and the walls before they change. Taking a snapshot copies
+ * the players, restoring one undoes the changes logged since, so both cost what changed and not the whole game.
+ * Snapshots are nested: restoring or releasing one drops the snapshots taken after it, and starting or resetting the
+ * game drops them all
+ */
+bool Model_snapshot(Model *self, ModelSnapshot *output);
+
+/**
+ * @brief Restore the game as it was when a snapshot was taken
+ * @param self The model
+ * @param snapshot The snapshot, that is kept and can be restored again
+ * @return True if the game was restored, false otherwise
+ */
+bool Model_restore(Model *self, const ModelSnapshot *snapshot);
+
+/**
+ * @brief Release a snapshot, that cannot be restored anymore
+ * @param self The model
+ * @param snapshot The snapshot
+ * @note The log is cleared once no snapshot is kept
+ */
+void Model_release(Model *self, const ModelSnapshot *snapshot);
+
 /**
  * @brief Remove a player
  * @param self The model
@@ -0,0 +1,158 @@
+#include "segments.h"
+
+#include <limits.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+bool Segments_grow(Arena *arena, int **array, const int allocated, const int to_allocate)
+{
+    int *tmp = Arena_grow(arena, *array, allocated * sizeof(int), to_allocate * sizeof(int));
+    if (tmp == NULL)
+        return false;
+    *array = tmp;
+    return true;
+}
+
+bool Segments_add(Segments *self, Arena *arena, const int min_x, const int max_x, const int min_y, const int max_y,
+                  const int owner)
+{
+    if (self->num_segments == self->allocated_segments)
+    {
+        const int allocated = self->allocated_segments;
+        const int to_allocate = allocated > 0 ? allocated * 2 : SEGMENT_INITIAL_CAPACITY;
+        if (!Segments_grow(arena, &self->min_x, allocated, to_allocate)
+            || !Segments_grow(arena, &self->max_x, allocated, to_allocate)
+            || !Segments_grow(arena, &self->min_y, allocated, to_allocate)
+            || !Segments_grow(arena, &self->max_y, allocated, to_allocate)
+            || !Segments_grow(arena, &self->owner, allocated, to_allocate))
+            return false;
+        self->allocated_segments = to_allocate;
+    }
+
+    const int i = self->num_segments;
+    self->min_x[i] = min_x;
+    self->max_x[i] = max_x;
+    self->min_y[i] = min_y;
+    self->max_y[i] = max_y;
+    self->owner[i] = owner;
+    self->num_segments++;
+    return true;
+}
+
+int Segments_first_hit(const Segments *self, const int x, const int y)
+{
+    const int n = self->num_segments;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // 8 segments at a time: the point is outside when any bound excludes it
+    const __m256i px = _mm256_set1_epi32(x);
+    const __m256i py = _mm256_set1_epi32(y);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i outside = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)&self->min_x[i]), px);
+        outside = _mm256_or_si256(outside,
+                                  _mm256_cmpgt_epi32(px, _mm256_loadu_si256((const __m256i *)&self->max_x[i])));
+        outside = _mm256_or_si256(outside,
+                                  _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)&self->min_y[i]), py));
+        outside = _mm256_or_si256(outside,
+                                  _mm256_cmpgt_epi32(py, _mm256_loadu_si256((const __m256i *)&self->max_y[i])));
+        const int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    // 4 segments at a time: the point is outside when any bound excludes it
+    const __m128i px = _mm_set1_epi32(x);
+    const __m128i py = _mm_set1_epi32(y);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i outside = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)&self->min_x[i]), px);
+        outside = _mm_or_si128(outside, _mm_cmpgt_epi32(px, _mm_loadu_si128((const __m128i *)&self->max_x[i])));
+        outside = _mm_or_si128(outside, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)&self->min_y[i]), py));
+        outside = _mm_or_si128(outside, _mm_cmpgt_epi32(py, _mm_loadu_si128((const __m128i *)&self->max_y[i])));
+        const int mask = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+
+    // scalar fallback, and the remaining segments
+    for (; i < n; i++)
+        if (self->min_x[i] <= x && x <= self->max_x[i] && self->min_y[i] <= y && y <= self->max_y[i])
+            return i;
+    return -1;
+}
+
+int Segments_ray_distance(const int min_x, const int max_x, const int min_y, const int max_y,
+                          const int x, const int y, const int dx, const int dy)
+{
+    if (dx > 0 && min_y <= y && y <= max_y && max_x >= x)
+        return (min_x > x ? min_x : x) - x;
+    if (dx < 0 && min_y <= y && y <= max_y && min_x <= x)
+        return x - (max_x < x ? max_x : x);
+    if (dy > 0 && min_x <= x && x <= max_x && max_y >= y)
+        return (min_y > y ? min_y : y) - y;
+    if (dy < 0 && min_x <= x && x <= max_x && min_y <= y)
+        return y - (max_y < y ? max_y : y);
+    return -1;
+}
+
+int Segments_raycast(const Segments *self, const int x, const int y, const int dx, const int dy, int *distance)
+{
+    // project the segments on the axis of the ray: lo/hi along it, perp_lo/perp_hi across it
+    const int *lo = dx != 0 ? self->min_x : self->min_y;
+    const int *hi = dx != 0 ? self->max_x : self->max_y;
+    const int *perp_lo = dx != 0 ? self->min_y : self->min_x;
+    const int *perp_hi = dx != 0 ? self->max_y : self->max_x;
+    const int position = dx != 0 ? x : y;
+    const int perp = dx != 0 ? y : x;
+    const int step = dx != 0 ? dx : dy;
+
+    // branchless loops over the arrays, so the compiler can vectorize them
+    int best = INT_MAX;
+    const int n = self->num_segments;
+    if (step > 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const int d = (lo[i] > position ? lo[i] : position) - position;
+            const bool on_ray = perp_lo[i] <= perp && perp <= perp_hi[i] && hi[i] >= position;
+            best = on_ray && d < best ? d : best;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const int d = position - (hi[i] < position ? hi[i] : position);
+            const bool on_ray = perp_lo[i] <= perp && perp <= perp_hi[i] && lo[i] <= position;
+            best = on_ray && d < best ? d : best;
+        }
+    }
+
+    if (best == INT_MAX)
+    {
+        *distance = -1;
+        return -1;
+    }
+
+    // find back the first segment at that distance
+    *distance = best;
+    return Segments_first_hit(self, dx != 0 ? x + dx * best : x, dx != 0 ? y : y + dy * best);
+}
+
+void Segments_remove(Segments *self, const int index)
+{
+    self->min_x[index] = 1;
+    self->max_x[index] = 0;
+    self->min_y[index] = 1;
+    self->max_y[index] = 0;
+}
+
+void Segments_clear(Segments *self)
+{
+    self->num_segments = 0;
+}
@@ -0,0 +1,84 @@
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+#include <stdbool.h>
+
+#include "arena.h"
+
+#define SEGMENT_INITIAL_CAPACITY 64
+// Walls as a structure of arrays, each one normalized to [min, max] on both axes, allocated in an arena
+typedef struct Segments {
+    int *min_x;
+    int *max_x;
+    int *min_y;
+    int *max_y;
+    int *owner;
+    int num_segments;
+    int allocated_segments;
+} Segments;
+
+/**
+ * @brief Add a segment
+ * @param self The segments
+ * @param arena The arena owning the arrays
+ * @param min_x The first column of the segment
+ * @param max_x The last column of the segment
+ * @param min_y The first row of the segment
+ * @param max_y The last row of the segment
+ * @param owner The owner of the segment
+ * @return True if the segment was added, false otherwise
+ */
+bool Segments_add(Segments *self, Arena *arena, const int min_x, const int max_x, const int min_y, const int max_y,
+                  const int owner);
+
+/**
+ * @brief Find the first segment containing a point
+ * @param self The segments
+ * @param x The x position
+ * @param y The y position
+ * @return The index of the segment, -1 if there is none
+ * @note Uses AVX2 or SSE2 when available to test several segments at once
+ */
+int Segments_first_hit(const Segments *self, const int x, const int y);
+
+/**
+ * @brief Get the distance from a point to a box along a ray
+ * @param min_x The first column of the box
+ * @param max_x The last column of the box
+ * @param min_y The first row of the box
+ * @param max_y The last row of the box
+ * @param x The x position of the ray origin
+ * @param y The y position of the ray origin
+ * @param dx The x step of the ray (-1, 0 or 1)
+ * @param dy The y step of the ray (-1, 0 or 1)
+ * @return The distance to the first cell of the box on the ray, -1 if the ray misses it
+ */
+int Segments_ray_distance(const int min_x, const int max_x, const int min_y, const int max_y,
+                          const int x, const int y, const int dx, const int dy);
+
+/**
+ * @brief Find the nearest segment along a ray
+ * @param self The segments
+ * @param x The x position of the ray origin
+ * @param y The y position of the ray origin
+ * @param dx The x step of the ray (-1, 0 or 1)
+ * @param dy The y step of the ray (-1, 0 or 1)
+ * @param distance The output distance to the segment
+ * @return The index of the segment, -1 if there is none
+ */
+int Segments_raycast(const Segments *self, const int x, const int y, const int dx, const int dy, int *distance);
+
+/**
+ * @brief Remove a segment, keeping the indices of the others
+ * @param self The segments
+ * @param index The index of the segment
+ * @note The segment becomes an empty box, that no point or ray can hit
+ */
+void Segments_remove(Segments *self, const int index);
+
+/**
+ * @brief Remove all the segments, keeping the memory
+ * @param self The segments
+ */
+void Segments_clear(Segments *self);
+
+#endif // SEGMENTS_H
@@ -0,0 +1,193 @@
+#include "shard.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+bool Shard_send(const int socket, const void *data, size_t size)
+{
+    const char *bytes = data;
+    while (size > 0)
+    {
+        const ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+bool Shard_receive(const int socket, void *data, size_t size)
+{
+    char *bytes = data;
+    while (size > 0)
+    {
+        const ssize_t received = recv(socket, bytes, size, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+bool Shard_fork(Shard *self, const int num_shards)
+{
+    memset(self, 0, sizeof(Shard));
+    if (num_shards < 1 || num_shards > SHARD_MAX_SHARDS)
+    {
+        debug_log("Invalid number of shards");
+        return false;
+    }
+    self->num_shards = num_shards;
+    for (int i = 0; i < SHARD_MAX_SHARDS; i++)
+    {
+        self->sockets[i] = -1;
+        self->children[i] = -1;
+    }
+
+    // a socket pair between each two shards, the lower index keeps the first end
+    static int pairs[SHARD_MAX_SHARDS][SHARD_MAX_SHARDS][2];
+    bool created = true;
+    for (int i = 0; i < num_shards; i++)
+        for (int j = i + 1; j < num_shards; j++)
+        {
+            pairs[i][j][0] = pairs[i][j][1] = -1;
+            if (created && socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[i][j]) != 0)
+                created = false;
+        }
+
+    // the children get the indices after the first shard
+    for (int i = 1; i < num_shards && created; i++)
+    {
+        const pid_t pid = fork();
+        if (pid < 0)
+            created = false;
+        else if (pid == 0)
+        {
+            // the other children belong to the first shard
+            self->index = i;
+            for (int j = 0; j < SHARD_MAX_SHARDS; j++)
+                self->children[j] = -1;
+            break;
+        }
+        else
+            self->children[i] = pid;
+    }
+
+    // each shard keeps its ends of the pairs and closes the others
+    for (int i = 0; i < num_shards; i++)
+        for (int j = i + 1; j < num_shards; j++)
+        {
+            if (i == self->index)
+                self->sockets[j] = pairs[i][j][0];
+            else if (pairs[i][j][0] >= 0)
+                close(pairs[i][j][0]);
+            if (j == self->index)
+                self->sockets[i] = pairs[i][j][1];
+            else if (pairs[i][j][1] >= 0)
+                close(pairs[i][j][1]);
+        }
+    if (!created)
+    {
+        debug_log("Failed to fork the shards");
+        if (self->index == 0)
+            Shard_destroy(self);
+        return false;
+    }
+    return true;
+}
+
+void Shard_get_columns(const Shard *self, const int width, int *min_x, int *max_x)
+{
+    // strips of equal width, the remainder spread over the first ones
+    const long long first = (long long)width * self->index / self->num_shards;
+    const long long next = (long long)width * (self->index + 1) / self->num_shards;
+    *min_x = (int)first;
+    *max_x = (int)next - 1;
+}
+
+int *Shard_get_values(Shard *self, const int count)
+{
+    if (count > self->allocated_values)
+    {
+        int *values = realloc(self->values, count * sizeof(int));
+        if (values == NULL)
+            return NULL;
+        self->values = values;
+        int *sums = realloc(self->sums, count * sizeof(int));
+        if (sums == NULL)
+            return NULL;
+        self->sums = sums;
+        int *received = realloc(self->received, count * sizeof(int));
+        if (received == NULL)
+            return NULL;
+        self->received = received;
+        self->allocated_values = count;
+    }
+    self->num_values = count;
+    memset(self->values, 0, count * sizeof(int));
+    return self->values;
+}
+
+bool Shard_sum_values(Shard *self)
+{
+    const size_t size = self->num_values * sizeof(int);
+    memcpy(self->sums, self->values, size);
+    for (int j = 0; j < self->num_shards; j++)
+    {
+        if (j == self->index)
+            continue;
+
+        // the lower index sends first, the higher one receives first
+        const int socket = self->sockets[j];
+        const bool exchanged = j > self->index
+                                   ? Shard_send(socket, self->values, size)
+                                     && Shard_receive(socket, self->received, size)
+                                   : Shard_receive(socket, self->received, size)
+                                     && Shard_send(socket, self->values, size);
+        if (!exchanged)
+        {
+            debug_logf("Failed to exchange with shard %d", j);
+            return false;
+        }
+        for (int i = 0; i < self->num_values; i++)
+            self->sums[i] += self->received[i];
+    }
+    memcpy(self->values, self->sums, size);
+    return true;
+}
+
+void Shard_destroy(Shard *self)
+{
+    for (int i = 0; i < SHARD_MAX_SHARDS; i++)
+        if (self->sockets[i] >= 0)
+        {
+            close(self->sockets[i]);
+            self->sockets[i] = -1;
+        }
+    for (int i = 0; i < SHARD_MAX_SHARDS; i++)
+        if (self->children[i] > 0)
+        {
+            waitpid(self->children[i], NULL, 0);
+            self->children[i] = -1;
+        }
+    free(self->values);
+    free(self->sums);
+    free(self->received);
+    self->values = NULL;
+    self->sums = NULL;
+    self->received = NULL;
+    self->num_values = 0;
+    self->allocated_values = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef SHARD_H
+#define SHARD_H
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define SHARD_MAX_SHARDS 64
+
+// Process simulating a strip of columns of the game area, connected to the other shards by local sockets
+typedef struct Shard {
+    int index;
+    int num_shards;
+    int sockets[SHARD_MAX_SHARDS]; // socket to each other shard, -1 for itself
+    pid_t children[SHARD_MAX_SHARDS]; // processes forked by the first shard
+
+    // Values of the shard, their sum over the shards, and the values received from a shard
+    int *values;
+    int *sums;
+    int *received;
+    int num_values;
+    int allocated_values;
+} Shard;
+
+/**
+ * @brief Fork the processes of the shards
+ * @param self The output shard of the calling process
+ * @param num_shards The number of shards
+ * @return True if the processes were forked, false otherwise
+ * @note Every process returns from this function with its own shard: the first one in the calling process, the others
+ * in the children. The children must call Shard_destroy then exit
+ */
+bool Shard_fork(Shard *self, const int num_shards);
+
+/**
+ * @brief Get the columns owned by a shard
+ * @param self The shard
+ * @param width The width of the game area
+ * @param min_x The output first column
+ * @param max_x The output last column
+ */
+void Shard_get_columns(const Shard *self, const int width, int *min_x, int *max_x);
+
+/**
+ * @brief Get the values to sum over the shards
+ * @param self The shard
+ * @param count The number of values
+ * @return The values, set to 0, NULL on failure
+ */
+int *Shard_get_values(Shard *self, const int count);
+
+/**
+ * @brief Replace the values of each shard by their sum over all the shards
+ * @param self The shard
+ * @return True if the values were exchanged, false otherwise
+ * @note Every shard must call it at the same time with the same number of values. The shards exchange in pairs, in
+ * the order of their indices, so the blocking sockets never deadlock
+ */
+bool Shard_sum_values(Shard *self);
+
+/**
+ * @brief Close the sockets of the shard, the first shard waits for the others to exit
+ * @param self The shard
+ */
+void Shard_destroy(Shard *self);
+
+#endif // SHARD_H
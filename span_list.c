@@ -0,0 +1,115 @@
+#include "span_list.h"
+
+#include <string.h>
+
+// index of the first span with max >= value, num_spans if there is none
+int SpanList_lower_bound(const SpanList *self, const int value)
+{
+    int low = 0;
+    int high = self->num_spans;
+    while (low < high)
+    {
+        const int middle = low + (high - low) / 2;
+        if (self->spans[middle].max < value)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+bool SpanList_reserve(SpanList *self, Arena *arena)
+{
+    if (self->num_spans < self->allocated_spans)
+        return true;
+    const int to_allocate = self->allocated_spans > 0 ? self->allocated_spans * 2 : SPAN_INITIAL_CAPACITY;
+    Span *tmp = Arena_grow(arena, self->spans, self->allocated_spans * sizeof(Span), to_allocate * sizeof(Span));
+    if (tmp == NULL)
+        return false;
+    self->spans = tmp;
+    self->allocated_spans = to_allocate;
+    return true;
+}
+
+bool SpanList_insert(SpanList *self, Arena *arena, const int min, const int max)
+{
+    // spans touching [min - 1, max + 1] are merged with the new one
+    const int first = SpanList_lower_bound(self, min - 1);
+    int last = first;
+    while (last < self->num_spans && self->spans[last].min <= max + 1)
+        last++;
+
+    if (first == last)
+    {
+        // no span to merge, make room for a new one
+        if (!SpanList_reserve(self, arena))
+            return false;
+        memmove(&self->spans[first + 1], &self->spans[first], (self->num_spans - first) * sizeof(Span));
+        self->spans[first].min = min;
+        self->spans[first].max = max;
+        self->num_spans++;
+        return true;
+    }
+
+    // merge spans [first, last) into the first one
+    Span *merged = &self->spans[first];
+    if (min < merged->min)
+        merged->min = min;
+    merged->max = self->spans[last - 1].max > max ? self->spans[last - 1].max : max;
+    memmove(&self->spans[first + 1], &self->spans[last], (self->num_spans - last) * sizeof(Span));
+    self->num_spans -= last - first - 1;
+    return true;
+}
+
+bool SpanList_remove(SpanList *self, Arena *arena, const int min, const int max)
+{
+    // spans overlapping [min, max]
+    int first = SpanList_lower_bound(self, min);
+    int last = first;
+    while (last < self->num_spans && self->spans[last].min <= max)
+        last++;
+    if (first == last)
+        return true;
+
+    if (last - first == 1 && self->spans[first].min < min && self->spans[first].max > max)
+    {
+        // the interval is inside a single span, split it
+        if (!SpanList_reserve(self, arena))
+            return false;
+        memmove(&self->spans[first + 2], &self->spans[first + 1], (self->num_spans - first - 1) * sizeof(Span));
+        self->spans[first + 1].min = max + 1;
+        self->spans[first + 1].max = self->spans[first].max;
+        self->spans[first].max = min - 1;
+        self->num_spans++;
+        return true;
+    }
+
+    // keep the parts of the first and the last spans outside of the interval, drop the others
+    if (self->spans[first].min < min)
+        self->spans[first++].max = min - 1;
+    if (self->spans[last - 1].max > max)
+        self->spans[--last].min = max + 1;
+    memmove(&self->spans[first], &self->spans[last], (self->num_spans - last) * sizeof(Span));
+    self->num_spans -= last - first;
+    return true;
+}
+
+const Span *SpanList_first_after(const SpanList *self, const int value)
+{
+    const int index = SpanList_lower_bound(self, value);
+    return index < self->num_spans ? &self->spans[index] : NULL;
+}
+
+const Span *SpanList_last_before(const SpanList *self, const int value)
+{
+    // the span containing value, if any, is the first one ending at or after it
+    const int index = SpanList_lower_bound(self, value);
+    if (index < self->num_spans && self->spans[index].min <= value)
+        return &self->spans[index];
+    return index > 0 ? &self->spans[index - 1] : NULL;
+}
+
+void SpanList_clear(SpanList *self)
+{
+    self->num_spans = 0;
+}
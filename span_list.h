@@ -0,0 +1,63 @@
+#ifndef SPAN_LIST_H
+#define SPAN_LIST_H
+#include <stdbool.h>
+
+#include "arena.h"
+
+// Inclusive interval [min, max] of occupied cells along a row or a column
+typedef struct Span {
+    int min;
+    int max;
+} Span;
+
+#define SPAN_INITIAL_CAPACITY 4
+// Sorted list of disjoint, non-adjacent spans, allocated in an arena
+typedef struct SpanList {
+    Span *spans;
+    int num_spans;
+    int allocated_spans;
+} SpanList;
+
+/**
+ * @brief Insert an interval, merging it with the overlapping or adjacent spans
+ * @param self The span list
+ * @param arena The arena owning the spans
+ * @param min The first cell of the interval
+ * @param max The last cell of the interval
+ * @return True if the interval was inserted, false otherwise
+ */
+bool SpanList_insert(SpanList *self, Arena *arena, const int min, const int max);
+
+/**
+ * @brief Remove an interval, splitting the span containing it if needed
+ * @param self The span list
+ * @param arena The arena owning the spans
+ * @param min The first cell of the interval
+ * @param max The last cell of the interval
+ * @return True if the interval was removed, false otherwise
+ */
+bool SpanList_remove(SpanList *self, Arena *arena, const int min, const int max);
+
+/**
+ * @brief Find the first span ending at or after a value
+ * @param self The span list
+ * @param value The value
+ * @return The span, NULL if there is none
+ */
+const Span *SpanList_first_after(const SpanList *self, const int value);
+
+/**
+ * @brief Find the last span starting at or before a value
+ * @param self The span list
+ * @param value The value
+ * @return The span, NULL if there is none
+ */
+const Span *SpanList_last_before(const SpanList *self, const int value);
+
+/**
+ * @brief Remove all the spans, keeping the memory
+ * @param self The span list
+ */
+void SpanList_clear(SpanList *self);
+
+#endif // SPAN_LIST_H
@@ -0,0 +1,114 @@
+#include "thread_pool.h"
+
+#include <stdlib.h>
+
+void ThreadPool_work(ThreadPool *self)
+{
+    for (;;)
+    {
+        const int first = atomic_fetch_add(&self->next, self->chunk);
+        if (first >= self->count)
+            return;
+        const int last = first + self->chunk < self->count ? first + self->chunk : self->count;
+        self->task(self->context, first, last);
+    }
+}
+
+void *ThreadPool_main(void *argument)
+{
+    ThreadPool *self = argument;
+    unsigned int generation = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&self->mutex);
+        while (!self->stop && self->generation == generation)
+            pthread_cond_wait(&self->start, &self->mutex);
+        if (self->stop)
+        {
+            pthread_mutex_unlock(&self->mutex);
+            return NULL;
+        }
+        generation = self->generation;
+        pthread_mutex_unlock(&self->mutex);
+
+        ThreadPool_work(self);
+
+        pthread_mutex_lock(&self->mutex);
+        if (--self->running == 0)
+            pthread_cond_signal(&self->done);
+        pthread_mutex_unlock(&self->mutex);
+    }
+}
+
+bool ThreadPool_init(ThreadPool *self, const int num_threads)
+{
+    self->threads = NULL;
+    self->num_threads = 0;
+    self->generation = 0;
+    self->running = 0;
+    self->stop = false;
+    self->task = NULL;
+    self->context = NULL;
+    self->count = 0;
+    self->chunk = 1;
+    atomic_init(&self->next, 0);
+    pthread_mutex_init(&self->mutex, NULL);
+    pthread_cond_init(&self->start, NULL);
+    pthread_cond_init(&self->done, NULL);
+    if (num_threads <= 0)
+        return true;
+
+    self->threads = malloc(num_threads * sizeof(pthread_t));
+    if (self->threads == NULL)
+        return false;
+    for (; self->num_threads < num_threads; self->num_threads++)
+        if (pthread_create(&self->threads[self->num_threads], NULL, ThreadPool_main, self) != 0)
+            return false;
+    return true;
+}
+
+void ThreadPool_run(ThreadPool *self, const int count, const int chunk, const ThreadPoolTask task, void *context)
+{
+    if (count <= 0)
+        return;
+    if (self->num_threads == 0 || count <= chunk)
+    {
+        task(context, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&self->mutex);
+    self->task = task;
+    self->context = context;
+    self->count = count;
+    self->chunk = chunk > 0 ? chunk : 1;
+    atomic_store(&self->next, 0);
+    self->running = self->num_threads;
+    self->generation++;
+    pthread_cond_broadcast(&self->start);
+    pthread_mutex_unlock(&self->mutex);
+
+    ThreadPool_work(self);
+
+    // the loop is over once every thread is back waiting for the next one
+    pthread_mutex_lock(&self->mutex);
+    while (self->running > 0)
+        pthread_cond_wait(&self->done, &self->mutex);
+    pthread_mutex_unlock(&self->mutex);
+}
+
+void ThreadPool_destroy(ThreadPool *self)
+{
+    pthread_mutex_lock(&self->mutex);
+    self->stop = true;
+    pthread_cond_broadcast(&self->start);
+    pthread_mutex_unlock(&self->mutex);
+    for (int i = 0; i < self->num_threads; i++)
+        pthread_join(self->threads[i], NULL);
+    free(self->threads);
+    self->threads = NULL;
+    self->num_threads = 0;
+    pthread_mutex_destroy(&self->mutex);
+    pthread_cond_destroy(&self->start);
+    pthread_cond_destroy(&self->done);
+}
@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Work on the items [first, last) of a parallel loop
+typedef void (*ThreadPoolTask)(void *context, int first, int last);
+
+// Threads running the chunks of a parallel loop, the calling thread takes part in the work
+typedef struct ThreadPool {
+    pthread_t *threads;
+    int num_threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t start; // signaled when a loop starts or the pool stops
+    pthread_cond_t done; // signaled when the last thread is done with a loop
+    unsigned int generation; // number of loops started, the threads wait for the next one
+    int running; // threads still working on the current loop
+    bool stop;
+
+    // Current loop: the threads take the next chunk until there is none left
+    ThreadPoolTask task;
+    void *context;
+    int count;
+    int chunk;
+    atomic_int next;
+} ThreadPool;
+
+/**
+ * @brief Start the threads of the pool
+ * @param self The thread pool
+ * @param num_threads The number of threads, besides the calling thread
+ * @return True if the threads were started, false otherwise
+ */
+bool ThreadPool_init(ThreadPool *self, const int num_threads);
+
+/**
+ * @brief Run a parallel loop and wait for its end
+ * @param self The thread pool
+ * @param count The number of items
+ * @param chunk The number of items taken at once by a thread
+ * @param task The work on a range of items
+ * @param context The context of the task
+ * @note The chunks are handed out in order from a shared counter, an idle thread takes the next one: the load is
+ * balanced whatever the cost of each item. Each item is processed exactly once
+ */
+void ThreadPool_run(ThreadPool *self, const int count, const int chunk, const ThreadPoolTask task, void *context);
+
+/**
+ * @brief Stop and join the threads of the pool
+ * @param self The thread pool
+ */
+void ThreadPool_destroy(ThreadPool *self);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,98 @@
+#include "tile_grid.h"
+
+#include <string.h>
+
+unsigned int TileGrid_hash(const int tx, const int ty)
+{
+    return (unsigned int)tx * 73856093u ^ (unsigned int)ty * 19349663u;
+}
+
+Tile *TileGrid_find(const TileGrid *self, const int tx, const int ty)
+{
+    if (self->num_slots == 0)
+        return NULL;
+
+    // linear probing, the table is never more than half full
+    const unsigned int mask = (unsigned int)self->num_slots - 1;
+    for (unsigned int slot = TileGrid_hash(tx, ty) & mask;; slot = (slot + 1) & mask)
+    {
+        Tile *tile = self->slots[slot];
+        if (tile == NULL || (tile->tx == tx && tile->ty == ty))
+            return tile;
+    }
+}
+
+void TileGrid_insert(TileGrid *self, Tile *tile)
+{
+    const unsigned int mask = (unsigned int)self->num_slots - 1;
+    unsigned int slot = TileGrid_hash(tile->tx, tile->ty) & mask;
+    while (self->slots[slot] != NULL)
+        slot = (slot + 1) & mask;
+    self->slots[slot] = tile;
+}
+
+bool TileGrid_reserve(TileGrid *self, Arena *arena)
+{
+    if (2 * (self->num_tiles + 1) <= self->num_slots)
+        return true;
+
+    // rehash into a table twice as large, the old one is left to the arena
+    const int num_slots = self->num_slots > 0 ? self->num_slots * 2 : TILE_GRID_INITIAL_SLOTS;
+    Tile **slots = Arena_alloc(arena, num_slots * sizeof(Tile *));
+    if (slots == NULL)
+        return false;
+    memset(slots, 0, num_slots * sizeof(Tile *));
+
+    Tile **old_slots = self->slots;
+    const int old_num_slots = self->num_slots;
+    self->slots = slots;
+    self->num_slots = num_slots;
+    for (int i = 0; i < old_num_slots; i++)
+        if (old_slots[i] != NULL)
+            TileGrid_insert(self, old_slots[i]);
+    return true;
+}
+
+Cell TileGrid_get(const TileGrid *self, const int x, const int y)
+{
+    const Tile *tile = TileGrid_find(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+    if (tile == NULL)
+        return CELL_EMPTY;
+    return tile->cells[(y & (TILE_SIZE - 1)) * TILE_SIZE + (x & (TILE_SIZE - 1))];
+}
+
+bool TileGrid_set(TileGrid *self, Arena *arena, const int x, const int y, const Cell cell)
+{
+    const int tx = x >> TILE_SHIFT;
+    const int ty = y >> TILE_SHIFT;
+    Tile *tile = self->last;
+    if (tile == NULL || tile->tx != tx || tile->ty != ty)
+        tile = TileGrid_find(self, tx, ty);
+
+    if (tile == NULL)
+    {
+        // first cell of the tile
+        if (!TileGrid_reserve(self, arena))
+            return false;
+        tile = Arena_alloc(arena, sizeof(Tile));
+        if (tile == NULL)
+            return false;
+        tile->tx = tx;
+        tile->ty = ty;
+        memset(tile->cells, CELL_EMPTY, sizeof(tile->cells));
+        TileGrid_insert(self, tile);
+        self->num_tiles++;
+    }
+
+    tile->cells[(y & (TILE_SIZE - 1)) * TILE_SIZE + (x & (TILE_SIZE - 1))] = cell;
+    self->last = tile;
+    return true;
+}
+
+void TileGrid_clear(TileGrid *self)
+{
+    self->slots = NULL;
+    self->num_slots = 0;
+    self->num_tiles = 0;
+    self->last = NULL;
+}
@@ -0,0 +1,56 @@
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+#include <stdbool.h>
+
+#include "arena.h"
+
+// Occupancy of a single cell of the game area: owner player index + 1, or CELL_EMPTY
+typedef unsigned short Cell;
+#define CELL_EMPTY 0
+
+#define TILE_SHIFT 4 // tiles of 16x16 cells, a straight trail wastes few cells of its tiles
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define TILE_GRID_INITIAL_SLOTS 64
+
+// Square block of cells, allocated when the first cell is set
+typedef struct Tile {
+    int tx;
+    int ty;
+    Cell cells[TILE_SIZE * TILE_SIZE];
+} Tile;
+
+// Sparse occupancy grid: the tiles are found by coordinates in an open addressing table, allocated in an arena
+typedef struct TileGrid {
+    Tile **slots;
+    int num_slots; // power of two
+    int num_tiles;
+    Tile *last; // last tile set, trails are mostly local
+} TileGrid;
+
+/**
+ * @brief Get a cell
+ * @param self The grid
+ * @param x The x position (not negative)
+ * @param y The y position (not negative)
+ * @return The cell, CELL_EMPTY if its tile was never set
+ */
+Cell TileGrid_get(const TileGrid *self, const int x, const int y);
+
+/**
+ * @brief Set a cell, allocating its tile if needed
+ * @param self The grid
+ * @param arena The arena owning the tiles
+ * @param x The x position (not negative)
+ * @param y The y position (not negative)
+ * @param cell The cell
+ * @return True if the cell was set, false otherwise
+ */
+bool TileGrid_set(TileGrid *self, Arena *arena, const int x, const int y, const Cell cell);
+
+/**
+ * @brief Forget all the tiles, their memory belongs to the arena
+ * @param self The grid
+ */
+void TileGrid_clear(TileGrid *self);
+
+#endif // TILE_GRID_H
@@ -25,6 +25,34 @@ int compose_flags(char **argv, const int argc)
             debug_logf("NCURSES flag found: %s", argv[i]);
             flag |= NCURSES_FLAG;
         }
+
+        // if headless flag is found, add it to the flags
+        else if (strcmp(argv[i], HEADLESS_FLAG_PROMPT) == 0)
+        {
+            debug_logf("HEADLESS flag found: %s", argv[i]);
+            flag |= HEADLESS_FLAG;
+        }
+
+        // if software flag is found, the SDL vue draws the game on the CPU
+        else if (strcmp(argv[i], SOFTWARE_FLAG_PROMPT) == 0)
+        {
+            debug_logf("SOFTWARE flag found: %s", argv[i]);
+            flag |= SOFTWARE_FLAG;
+        }
+
+        // if checksum flag is found, the checksum of the game is logged after each update
+        else if (strcmp(argv[i], CHECKSUM_FLAG_PROMPT) == 0)
+        {
+            debug_logf("CHECKSUM flag found: %s", argv[i]);
+            flag |= CHECKSUM_FLAG;
+        }
+    }
+
+    // if it has the headless flag, no vue is drawn
+    if (flag & HEADLESS_FLAG)
+    {
+        debug_logf("Headless flag found: %d", flag);
+        return HEADLESS_FLAG | (flag & CHECKSUM_FLAG);
     }
 
     // if it has both flags, remove the ncurses flag
@@ -44,6 +72,17 @@ int compose_flags(char **argv, const int argc)
     return flag;
 }
 
+const char *find_option(char **argv, const int argc, const char *prompt)
+{
+    for (int i = 1; i + 1 < argc; i++)
+        if (strcmp(argv[i], prompt) == 0)
+        {
+            debug_logf("Option %s found: %s", prompt, argv[i + 1]);
+            return argv[i + 1];
+        }
+    return NULL;
+}
+
 void debug_log(const char *content)
 {
     FILE *file = fopen("tron.log", "a");
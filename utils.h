@@ -5,6 +5,13 @@
 #define SDL_FLAG 1
 #define NCURSES_FLAG_PROMPT "-ncurses"
 #define NCURSES_FLAG 2
+#define HEADLESS_FLAG_PROMPT "-headless"
+#define HEADLESS_FLAG 4
+#define SOFTWARE_FLAG_PROMPT "-software"
+#define SOFTWARE_FLAG 8
+#define CHECKSUM_FLAG_PROMPT "-log-checksum"
+#define CHECKSUM_FLAG 16
+#define MAP_OPTION_PROMPT "-map"
 
 /**
  * @brief Compose the flags from the arguments
@@ -14,6 +21,15 @@
  */
 int compose_flags(char **argv, const int argc);
 
+/**
+ * @brief Find the value of an option in the arguments
+ * @param argv String array of arguments
+ * @param argc Number of arguments
+ * @param prompt The option, followed by its value
+ * @return The value of the option, NULL if it is not found
+ */
+const char *find_option(char **argv, const int argc, const char *prompt);
+
 /**
  * @brief Log a message to a file
  * @param content The content to log
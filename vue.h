@@ -1,7 +1,8 @@
 #ifndef VUE_H
 #define VUE_H
 
-#define GAME_FPS 20
+#define GAME_FPS 20 // updates of the game in a second
+#define RENDER_FPS 60 // frames drawn in a second at most
 
 typedef struct Tron Tron; // Forward declaration
 
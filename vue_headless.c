@@ -0,0 +1,811 @@
+#include "vue_headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tron.h"
+#include "utils.h"
+
+bool VueHeadless_read_option(char **argv, const int argc, const char *prompt, const long long fallback,
+                             const long long min, long long *output)
+{
+    const char *value = find_option(argv, argc, prompt);
+    if (value == NULL)
+    {
+        *output = fallback;
+        return true;
+    }
+    char *end;
+    *output = strtoll(value, &end, 10);
+    if (*end != '\0' || end == value || *output < min)
+    {
+        debug_logf("Invalid option %s: %s", prompt, value);
+        return false;
+    }
+    return true;
+}
+
+bool VueHeadless_init(VueHeadless *self, char **argv, const int argc)
+{
+    memset(self, 0, sizeof(VueHeadless));
+    self->base.main = VueHeadless_main;
+    self->script = find_option(argv, argc, HEADLESS_SCRIPT_PROMPT);
+    self->check = find_option(argv, argc, HEADLESS_CHECK_PROMPT);
+    self->write_map = find_option(argv, argc, HEADLESS_WRITE_MAP_PROMPT);
+
+    const char *storage = find_option(argv, argc, HEADLESS_STORAGE_PROMPT);
+    if (storage != NULL && strcmp(storage, "segments") == 0)
+        self->storage = MODEL_STORAGE_SEGMENTS;
+    else if (storage != NULL && strcmp(storage, "grid") != 0)
+    {
+        debug_logf("Invalid option %s: %s", HEADLESS_STORAGE_PROMPT, storage);
+        return false;
+    }
+
+    long long matches, ticks, players, width, height, speed, threads, shards, seed, lifetime, respawn;
+    if (!VueHeadless_read_option(argv, argc, HEADLESS_MATCHES_PROMPT, HEADLESS_DEFAULT_MATCHES, 1, &matches)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_TICKS_PROMPT, HEADLESS_DEFAULT_TICKS, 1, &ticks)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_PLAYERS_PROMPT, HEADLESS_DEFAULT_PLAYERS, 1, &players)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_WIDTH_PROMPT, HEADLESS_DEFAULT_SIZE, 1, &width)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_HEIGHT_PROMPT, HEADLESS_DEFAULT_SIZE, 1, &height)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_SPEED_PROMPT, 1, 1, &speed)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_THREADS_PROMPT, 0, 0, &threads)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_SHARDS_PROMPT, 1, 1, &shards)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_SEED_PROMPT, 1, 0, &seed)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_ENDLESS_PROMPT, 0, 0, &lifetime)
+        || !VueHeadless_read_option(argv, argc, HEADLESS_RESPAWN_PROMPT, HEADLESS_DEFAULT_RESPAWN, 0, &respawn))
+        return false;
+    if (matches > 1000000000 || ticks > 1000000000 || players > MODEL_MAX_PLAYERS || width > MODEL_MAX_SIZE
+        || height > MODEL_MAX_SIZE || speed > MODEL_MAX_SIZE || threads > 1024 || shards > SHARD_MAX_SHARDS
+        || lifetime > 1000000000 || respawn > 1000000000)
+    {
+        debug_log("Headless option out of range");
+        return false;
+    }
+    self->matches = (int)matches;
+    self->ticks = (int)ticks;
+    self->players = (int)players;
+    self->width = (int)width;
+    self->height = (int)height;
+    self->speed = (int)speed;
+    self->threads = (int)threads;
+    self->shards = (int)shards;
+    self->seed = (unsigned long long)seed;
+    self->mode = find_option(argv, argc, HEADLESS_ENDLESS_PROMPT) != NULL ? GAME_MODE_ENDLESS : GAME_MODE_CLASSIC;
+    self->trail_lifetime = (int)lifetime;
+    self->respawn_delay = (int)respawn;
+    if (self->shards > 1 && self->mode == GAME_MODE_ENDLESS)
+    {
+        debug_log("Endless mode cannot be sharded");
+        return false;
+    }
+    return true;
+}
+
+bool VueHeadless_load_script(const char *path, HeadlessInput **inputs, int *count)
+{
+    *inputs = NULL;
+    *count = 0;
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        debug_logf("Failed to open script %s", path);
+        return false;
+    }
+
+    static const char *directions[] = {"up", "down", "left", "right"};
+    int allocated = 0;
+    int line_number = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        const char *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0')
+            continue;
+
+        HeadlessInput input = {0, 0, -1};
+        char direction[16];
+        if (sscanf(text, "%d %d %15s", &input.tick, &input.player, direction) == 3)
+            for (int d = 0; d < 4; d++)
+                if (strcmp(direction, directions[d]) == 0)
+                    input.direction = d;
+        if (input.direction < 0 || input.tick < 0 || input.player < 0
+            || (*count > 0 && input.tick < (*inputs)[*count - 1].tick))
+        {
+            debug_logf("Invalid script line %s:%d", path, line_number);
+            fclose(file);
+            free(*inputs);
+            *inputs = NULL;
+            *count = 0;
+            return false;
+        }
+
+        if (*count == allocated)
+        {
+            allocated = allocated > 0 ? allocated * 2 : 64;
+            HeadlessInput *grown = realloc(*inputs, allocated * sizeof(HeadlessInput));
+            if (grown == NULL)
+            {
+                debug_log("Failed to allocate the script");
+                fclose(file);
+                free(*inputs);
+                *inputs = NULL;
+                *count = 0;
+                return false;
+            }
+            *inputs = grown;
+        }
+        (*inputs)[(*count)++] = input;
+    }
+    fclose(file);
+    debug_logf("Script %s: %d inputs", path, *count);
+    return true;
+}
+
+unsigned long long VueHeadless_random(unsigned long long *state)
+{
+    // splitmix64
+    unsigned long long z = *state += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+    return z ^ z >> 31;
+}
+
+bool VueHeadless_play_bots(const VueHeadless *self, unsigned long long *random)
+{
+    Controller *controller = self->base.game->controller;
+    const int num_players = Controller_get_player_count(controller);
+
+    // a shard only knows the cells of its strip and of the halo around it
+    int min_x = 0;
+    int max_x = self->base.game->model->width - 1;
+    int local_moves[MODEL_MAX_PLAYERS];
+    int *moves = local_moves;
+    if (controller->shard != NULL)
+    {
+        Shard_get_columns(controller->shard, self->base.game->model->width, &min_x, &max_x);
+        moves = Shard_get_values(controller->shard, num_players);
+        if (moves == NULL)
+            return false;
+    }
+    else
+        memset(local_moves, 0, num_players * sizeof(int));
+
+    for (int i = 0; i < num_players; i++)
+    {
+        const Player *player = Controller_get_player(controller, i);
+        if (player->state != PLAYER_STATE_ALIVE) continue;
+
+        // keep going while the next cell is free, but turn from time to time
+        const unsigned long long roll = VueHeadless_random(random);
+        if (player->x < min_x || player->x > max_x) continue;
+        const int free_cells = Controller_get_free_neighbors(controller, player->x, player->y);
+        if (free_cells >> player->direction & 1 && roll % HEADLESS_TURN_CHANCE != 0) continue;
+
+        // pick one of the other free directions
+        int turns = free_cells & ~(1 << player->direction);
+        if (turns == 0) continue;
+        for (int skip = (int)(roll / HEADLESS_TURN_CHANCE % __builtin_popcount(turns)); skip > 0; skip--)
+            turns &= turns - 1;
+        moves[i] = __builtin_ctz(turns) + 1;
+    }
+
+    // the turns are played once all the bots picked theirs: a turn fills the head cell of its player, the bots after
+    // it would see other free cells than in a shard. Each player was moved by a single shard, the others left a 0
+    if (controller->shard != NULL && !Shard_sum_values(controller->shard))
+        return false;
+    for (int i = 0; i < num_players; i++)
+        if (moves[i] > 0)
+            Controller_move_player(controller, i, moves[i] - 1);
+    return true;
+}
+
+bool VueHeadless_start_match(const VueHeadless *self, const int match, unsigned long long *random)
+{
+    Controller *controller = self->base.game->controller;
+    while (Controller_get_player_count(controller) < self->players)
+        Controller_new_player(controller);
+    while (Controller_get_player_count(controller) > self->players)
+        Controller_remove_player(controller, Controller_get_player_count(controller) - 1);
+    Controller_play(controller, self->width, self->height);
+    if (Controller_get_state(controller) != GAME_STATE_PLAYING)
+    {
+        debug_logf("Failed to start match %d", match + 1);
+        return false;
+    }
+
+    // each match has its own bots, whatever the matches before it
+    *random = self->seed + (unsigned long long)match * 0x9e3779b97f4a7c15ULL;
+    return true;
+}
+
+int VueHeadless_count_cells(const Model *model)
+{
+    int owned = 0;
+    for (int y = 0; y < model->height; y++)
+        for (int x = 0; x < model->width; x++)
+            if (Model_get_cell_owner(model, x, y) >= 0)
+                owned++;
+    return owned;
+}
+
+bool VueHeadless_play_match(const VueHeadless *self, const int match, const HeadlessInput *inputs,
+                            const int num_inputs, HeadlessMatch *output)
+{
+    Controller *controller = self->base.game->controller;
+    unsigned long long random;
+    if (!VueHeadless_start_match(self, match, &random))
+        return false;
+    int next_input = 0;
+    int tick = 0;
+    while (tick < self->ticks && Controller_get_state(controller) == GAME_STATE_PLAYING)
+    {
+        if (self->script != NULL)
+            for (; next_input < num_inputs && inputs[next_input].tick <= tick; next_input++)
+            {
+                if (inputs[next_input].player < Controller_get_player_count(controller))
+                    Controller_move_player(controller, inputs[next_input].player, inputs[next_input].direction);
+            }
+        else if (!VueHeadless_play_bots(self, &random))
+        {
+            debug_log("Failed to share the moves of the bots");
+            Controller_game_over(controller);
+            return false;
+        }
+        Controller_update(controller);
+        tick++;
+    }
+
+    output->ticks = tick;
+    output->alive = 0;
+    for (int i = 0; i < Controller_get_player_count(controller); i++)
+        if (Controller_get_player(controller, i)->state == PLAYER_STATE_ALIVE)
+            output->alive++;
+    output->checksum = Controller_get_checksum(controller);
+    if (Controller_get_state(controller) == GAME_STATE_PLAYING)
+        Controller_game_over(controller);
+    return true;
+}
+
+bool VueHeadless_check_storage(const VueHeadless *self)
+{
+    // the same matches with each storage, the SIMD scan of the segments against the grid
+    Controller *controller = self->base.game->controller;
+    bool passed = true;
+    for (int match = 0; match < self->matches; match++)
+    {
+        HeadlessMatch grid, segments;
+        Controller_set_storage(controller, MODEL_STORAGE_GRID);
+        if (!VueHeadless_play_match(self, match, NULL, 0, &grid))
+            return false;
+        Controller_set_storage(controller, MODEL_STORAGE_SEGMENTS);
+        if (!VueHeadless_play_match(self, match, NULL, 0, &segments))
+            return false;
+        printf("match %d: grid %016llx, segments %016llx\n", match + 1, grid.checksum, segments.checksum);
+        passed = passed && grid.checksum == segments.checksum && grid.ticks == segments.ticks;
+    }
+    Controller_set_storage(controller, self->storage);
+    return passed;
+}
+
+bool VueHeadless_check_threads(const VueHeadless *self)
+{
+    Controller *controller = self->base.game->controller;
+    VueHeadless game = *self;
+    if (game.players < CONTROLLER_PARALLEL_MIN_PLAYERS)
+        game.players = CONTROLLER_PARALLEL_MIN_PLAYERS;
+    const int threads = self->threads > 0 ? self->threads : HEADLESS_CHECK_THREADS;
+
+    bool passed = true;
+    for (ModelStorage storage = MODEL_STORAGE_GRID; storage <= MODEL_STORAGE_SEGMENTS; storage++)
+    {
+        Controller_set_storage(controller, storage);
+        for (int match = 0; match < self->matches && passed; match++)
+        {
+            HeadlessMatch alone, parallel;
+            if (!Controller_set_threads(controller, 0) || !VueHeadless_play_match(&game, match, NULL, 0, &alone)
+                || !Controller_set_threads(controller, threads)
+                || !VueHeadless_play_match(&game, match, NULL, 0, &parallel))
+            {
+                passed = false;
+                break;
+            }
+            printf("%s match %d: %d players, %d ticks, %d alive, checksum %016llx, %d threads: %d ticks, %d alive, "
+                   "checksum %016llx\n", storage == MODEL_STORAGE_GRID ? "grid" : "segments", match + 1, game.players,
+                   alone.ticks, alone.alive, alone.checksum, threads, parallel.ticks, parallel.alive,
+                   parallel.checksum);
+            passed = alone.ticks == parallel.ticks && alone.alive == parallel.alive
+                     && alone.checksum == parallel.checksum;
+        }
+    }
+    Controller_set_storage(controller, self->storage);
+    return Controller_set_threads(controller, self->threads) && passed;
+}
+
+bool VueHeadless_check_endless(const VueHeadless *self)
+{
+    Controller *controller = self->base.game->controller;
+    const Model *model = self->base.game->model;
+    const int lifetime = self->trail_lifetime > 0 ? self->trail_lifetime : 20;
+    Controller_set_mode(controller, GAME_MODE_ENDLESS, lifetime, self->respawn_delay);
+    unsigned long long random;
+    if (!VueHeadless_start_match(self, 0, &random))
+    {
+        Controller_set_mode(controller, self->mode, self->trail_lifetime, self->respawn_delay);
+        return false;
+    }
+
+    int expired = 0, leaked = 0, compactions = 0, respawns = 0, most_walls = 0;
+    int states[MODEL_MAX_PLAYERS];
+    for (int i = 0; i < Controller_get_player_count(controller); i++)
+        states[i] = Controller_get_player(controller, i)->state;
+    for (int tick = 0; tick < self->ticks && Controller_get_state(controller) == GAME_STATE_PLAYING; tick++)
+    {
+        const int num_walls = model->num_walls;
+        VueHeadless_play_bots(self, &random);
+        Controller_update(controller);
+        if (model->num_walls < num_walls)
+            compactions++;
+        if (model->num_walls > most_walls)
+            most_walls = model->num_walls;
+        for (int i = 0; i < Controller_get_player_count(controller); i++)
+        {
+            const int state = Controller_get_player(controller, i)->state;
+            if (states[i] == PLAYER_STATE_DEAD && state == PLAYER_STATE_ALIVE)
+                respawns++;
+            states[i] = state;
+        }
+
+        // no wall outlives the lifetime, and the cells of the removed walls are free: the owned cells are the ones
+        // of the walls and of the live trails, without their heads
+        int cells = 0;
+        for (int i = 0; i < model->num_players; i++)
+            if (model->players[i].state == PLAYER_STATE_ALIVE && model->players[i].trail_length > 0)
+                cells += model->players[i].trail_length - 1;
+        for (int i = 0; i < model->num_walls; i++)
+        {
+            const Wall wall = Model_get_wall(model, i);
+            if (wall.length == 0)
+                continue;
+            cells += wall.length;
+            if (model->links[i].tick + lifetime <= model->tick)
+                expired++;
+        }
+        if (VueHeadless_count_cells(model) != cells)
+            leaked++;
+    }
+
+    const bool playing = Controller_get_state(controller) == GAME_STATE_PLAYING;
+    printf("endless: %d expired walls, %d leaked updates, %d compactions, %d respawns, %d walls at most\n", expired,
+           leaked, compactions, respawns, most_walls);
+    if (playing)
+        Controller_game_over(controller);
+    Controller_set_mode(controller, self->mode, self->trail_lifetime, self->respawn_delay);
+    return playing && expired == 0 && leaked == 0 && compactions > 0 && respawns > 0;
+}
+
+bool VueHeadless_check_snapshot(const VueHeadless *self)
+{
+    Controller *controller = self->base.game->controller;
+    Model *model = self->base.game->model;
+    bool passed = true;
+    for (int match = 0; match < self->matches; match++)
+    {
+        unsigned long long random;
+        if (!VueHeadless_start_match(self, match, &random))
+            return false;
+        int tick = 0;
+        for (; tick < self->ticks / 4 && Controller_get_state(controller) == GAME_STATE_PLAYING; tick++)
+        {
+            VueHeadless_play_bots(self, &random);
+            Controller_update(controller);
+        }
+
+        ModelSnapshot snapshot;
+        if (!Model_snapshot(model, &snapshot))
+        {
+            debug_log("Failed to take a snapshot");
+            Controller_game_over(controller);
+            return false;
+        }
+        const unsigned long long checksum = Controller_get_checksum(controller);
+        const unsigned long long bots = random;
+        const int num_walls = model->num_walls;
+        const int cells = VueHeadless_count_cells(model);
+
+        // the rest of the match, then again from the snapshot with the same bots
+        unsigned long long ends[2];
+        for (int run = 0; run < 2; run++)
+        {
+            for (int i = tick; i < self->ticks && Controller_get_state(controller) == GAME_STATE_PLAYING; i++)
+            {
+                VueHeadless_play_bots(self, &random);
+                Controller_update(controller);
+            }
+            ends[run] = Controller_get_checksum(controller);
+            if (run > 0)
+                break;
+
+            if (!Model_restore(model, &snapshot))
+            {
+                debug_log("Failed to restore a snapshot");
+                passed = false;
+            }
+            random = bots;
+            printf("match %d: checksum %016llx, %d walls, %d cells, restored %016llx, %d walls, %d cells\n",
+                   match + 1, checksum, num_walls, cells, Controller_get_checksum(controller), model->num_walls,
+                   VueHeadless_count_cells(model));
+            passed = passed && Controller_get_checksum(controller) == checksum && model->num_walls == num_walls
+                     && VueHeadless_count_cells(model) == cells;
+        }
+        passed = passed && ends[0] == ends[1];
+        Model_release(model, &snapshot);
+        if (Controller_get_state(controller) == GAME_STATE_PLAYING)
+            Controller_game_over(controller);
+    }
+    return passed;
+}
+
+bool VueHeadless_fork_shards(const VueHeadless *self, const int num_shards, Shard *shard)
+{
+    // the output buffered before the fork would be written by every shard
+    fflush(stdout);
+    if (!Shard_fork(shard, num_shards))
+        return false;
+    Controller_set_shard(self->base.game->controller, shard);
+    return true;
+}
+
+void VueHeadless_join_shards(const VueHeadless *self, Shard *shard)
+{
+    Controller_set_shard(self->base.game->controller, NULL);
+    Shard_destroy(shard);
+}
+
+bool VueHeadless_covers_cell(const Model *model, const int player, const int x, const int y)
+{
+    int min_x, max_x, min_y, max_y;
+    for (int i = 0; i < model->num_walls; i++)
+    {
+        const Wall wall = Model_get_wall(model, i);
+        if (wall.length == 0 || wall.player != player)
+            continue;
+        Model_get_wall_bounds(wall.x, wall.y, wall.direction, wall.length, &min_x, &max_x, &min_y, &max_y);
+        if (min_x <= x && x <= max_x && min_y <= y && y <= max_y)
+            return true;
+    }
+
+    // or its live trail
+    Wall wall;
+    int distance;
+    Model_get_player_wall(model, player, &wall, &distance);
+    if (model->players[player].state != PLAYER_STATE_ALIVE || wall.length == 0)
+        return false;
+    Model_get_wall_bounds(wall.x, wall.y, wall.direction, wall.length, &min_x, &max_x, &min_y, &max_y);
+    return min_x <= x && x <= max_x && min_y <= y && y <= max_y;
+}
+
+bool VueHeadless_check_shards(const VueHeadless *self)
+{
+    Controller *controller = self->base.game->controller;
+    const Model *model = self->base.game->model;
+    const int num_shards = self->shards > 1 ? self->shards : HEADLESS_CHECK_SHARDS;
+
+    // the matches of a single process: the players and the owners of the cells at the end of each match
+    HeadlessMatch *results = malloc(self->matches * sizeof(HeadlessMatch));
+    Player *players = malloc((size_t)self->matches * MODEL_MAX_PLAYERS * sizeof(Player));
+    int *cells = NULL;
+    int area = 0;
+    bool passed = results != NULL && players != NULL;
+    for (int match = 0; match < self->matches && passed; match++)
+    {
+        passed = VueHeadless_play_match(self, match, NULL, 0, &results[match]);
+        if (!passed)
+            break;
+        if (cells == NULL)
+        {
+            area = model->width * model->height;
+            cells = malloc((size_t)self->matches * area * sizeof(int));
+            if (cells == NULL)
+            {
+                passed = false;
+                break;
+            }
+        }
+        memcpy(&players[match * MODEL_MAX_PLAYERS], model->players, model->num_players * sizeof(Player));
+        for (int y = 0; y < model->height; y++)
+            for (int x = 0; x < model->width; x++)
+                cells[match * area + y * model->width + x] = Model_get_cell_owner(model, x, y);
+    }
+
+    // then by the shards, each one compares its strip
+    Shard shard;
+    if (!passed || !Controller_set_threads(controller, 0) || !VueHeadless_fork_shards(self, num_shards, &shard))
+    {
+        free(results);
+        free(players);
+        free(cells);
+        return false;
+    }
+    int mismatches = Controller_set_threads(controller, self->threads) ? 0 : 1;
+    int min_x, max_x;
+    for (int match = 0; match < self->matches; match++)
+    {
+        HeadlessMatch result;
+        if (!VueHeadless_play_match(self, match, NULL, 0, &result))
+        {
+            mismatches++;
+            break;
+        }
+        Shard_get_columns(&shard, model->width, &min_x, &max_x);
+        if (result.ticks != results[match].ticks || result.alive != results[match].alive)
+            mismatches++;
+        for (int i = 0; i < model->num_players; i++)
+        {
+            const Player *expected = &players[match * MODEL_MAX_PLAYERS + i];
+            const Player *player = &model->players[i];
+            if (player->x != expected->x || player->y != expected->y || player->direction != expected->direction
+                || player->state != expected->state || player->score != expected->score)
+                mismatches++;
+        }
+        for (int y = 0; y < model->height; y++)
+            for (int x = min_x; x <= max_x; x++)
+            {
+                const int expected = cells[match * area + y * model->width + x];
+                const int owner = Model_get_cell_owner(model, x, y);
+                if (owner != expected && (owner < 0 || expected < 0 || !VueHeadless_covers_cell(model, expected, x, y)))
+                    mismatches++;
+            }
+        if (shard.index == 0)
+            printf("match %d: %d ticks, %d alive\n", match + 1, result.ticks, result.alive);
+    }
+
+    int *values = Shard_get_values(&shard, 1);
+    if (values != NULL)
+    {
+        values[0] = mismatches;
+        passed = Shard_sum_values(&shard) && values[0] == 0;
+        mismatches = values[0];
+    }
+    else
+        passed = false;
+    const int index = shard.index;
+    Controller_set_threads(controller, 0);
+    VueHeadless_join_shards(self, &shard);
+    free(results);
+    free(players);
+    free(cells);
+    if (index != 0)
+        exit(0);
+    printf("shards: %d processes, %d mismatches\n", num_shards, mismatches);
+    return passed;
+}
+
+void VueHeadless_generate_map(const VueHeadless *self, unsigned char *cells, MapSpawn *spawns)
+{
+    unsigned long long random = self->seed;
+    memset(cells, 0, (size_t)self->width * self->height);
+    for (int block = 0; block < self->width * self->height / HEADLESS_MAP_BLOCK_CELLS; block++)
+    {
+        const int x = (int)(VueHeadless_random(&random) % (unsigned long long)self->width);
+        const int y = (int)(VueHeadless_random(&random) % (unsigned long long)self->height);
+        const int w = 1 + (int)(VueHeadless_random(&random) % HEADLESS_MAP_BLOCK_SIZE);
+        const int h = 1 + (int)(VueHeadless_random(&random) % HEADLESS_MAP_BLOCK_SIZE);
+        for (int cy = y; cy < y + h && cy < self->height; cy++)
+            memset(&cells[(size_t)cy * self->width + x], 1, x + w < self->width ? w : self->width - x);
+    }
+
+    for (int i = 0; i < self->players; i++)
+    {
+        const Direction direction = i % 2 == 0 ? DIRECTION_UP : DIRECTION_DOWN;
+        spawns[i] = (MapSpawn){(unsigned int)((i + 1) * self->width / (self->players + 1)),
+                               (unsigned int)(self->height / 2), (unsigned int)direction, 0};
+        int dx, dy;
+        Model_get_relative_direction(direction, &dx, &dy);
+        for (int d = 0; d <= HEADLESS_MAP_CLEARANCE; d++)
+        {
+            const int y = (int)spawns[i].y + dy * d;
+            if (y >= 0 && y < self->height)
+                cells[(size_t)y * self->width + spawns[i].x] = 0;
+        }
+    }
+}
+
+bool VueHeadless_write_map(const VueHeadless *self, const char *path)
+{
+    unsigned char *cells = malloc((size_t)self->width * self->height);
+    MapSpawn spawns[MODEL_MAX_PLAYERS];
+    if (cells == NULL)
+        return false;
+    VueHeadless_generate_map(self, cells, spawns);
+    const bool written = Map_write(path, self->width, self->height, cells, spawns, self->players);
+    if (!written)
+        debug_logf("Failed to write map %s", path);
+    free(cells);
+    return written;
+}
+
+bool VueHeadless_check_map(const VueHeadless *self)
+{
+    char path[] = "/tmp/tron-map-XXXXXX";
+    const int file = mkstemp(path);
+    if (file < 0)
+        return false;
+    close(file);
+    unsigned char *cells = malloc((size_t)self->width * self->height);
+    MapSpawn spawns[MODEL_MAX_PLAYERS];
+    Map map;
+    if (cells == NULL || !VueHeadless_write_map(self, path) || !Map_open(&map, path))
+    {
+        unlink(path);
+        free(cells);
+        return false;
+    }
+    VueHeadless_generate_map(self, cells, spawns);
+
+    int mismatches = 0;
+    if (map.width != self->width || map.height != self->height || map.num_spawns != self->players
+        || memcmp(map.spawns, spawns, self->players * sizeof(MapSpawn)) != 0)
+        mismatches++;
+    for (int y = 0; y < self->height && mismatches == 0; y++)
+    {
+        // the obstacles, and the runs of each row
+        for (int x = 0; x < self->width; x++)
+            if (Map_is_obstacle(&map, x, y) != (cells[(size_t)y * self->width + x] != 0))
+                mismatches++;
+        int min_x, max_x;
+        for (int x = 0; Map_next_run(&map, y, x, &min_x, &max_x); x = max_x + 1)
+        {
+            const unsigned char *row = &cells[(size_t)y * self->width];
+            for (int i = x; i < min_x; i++)
+                mismatches += row[i] != 0;
+            for (int i = min_x; i <= max_x; i++)
+                mismatches += row[i] == 0;
+            mismatches += max_x + 1 < self->width && row[max_x + 1] != 0;
+        }
+    }
+
+    // the raycasts from random cells, to the edge and to a limit, against a scan of the cells
+    unsigned long long random = self->seed;
+    for (int ray = 0; ray < HEADLESS_CHECK_RAYS && mismatches == 0; ray++)
+    {
+        const int x = (int)(VueHeadless_random(&random) % (unsigned long long)self->width);
+        const int y = (int)(VueHeadless_random(&random) % (unsigned long long)self->height);
+        const int limit = ray % 2 == 0 ? -1 : (int)(VueHeadless_random(&random) % 200);
+        int dx, dy;
+        Model_get_relative_direction(ray / 2 % 4, &dx, &dy);
+        int expected = -1;
+        for (int d = 0; (limit < 0 || d <= limit) && x + dx * d >= 0 && x + dx * d < self->width
+                        && y + dy * d >= 0 && y + dy * d < self->height; d++)
+            if (cells[(size_t)(y + dy * d) * self->width + x + dx * d] != 0)
+            {
+                expected = d;
+                break;
+            }
+        if (Map_raycast(&map, x, y, dx, dy, limit) != expected)
+            mismatches++;
+    }
+    Map_close(&map);
+
+    // and a match on the map
+    Controller *controller = self->base.game->controller;
+    HeadlessMatch result;
+    const bool played = Controller_load_map(controller, path) && VueHeadless_play_match(self, 0, NULL, 0, &result);
+    Controller_unload_map(controller);
+    unlink(path);
+    free(cells);
+    printf("map: %dx%d, %d mismatches, %s\n", self->width, self->height, mismatches,
+           played ? "played" : "not played");
+    return mismatches == 0 && played;
+}
+
+int VueHeadless_check(const VueHeadless *self)
+{
+    bool passed;
+    if (strcmp(self->check, "storage") == 0)
+        passed = VueHeadless_check_storage(self);
+    else if (strcmp(self->check, "threads") == 0)
+        passed = VueHeadless_check_threads(self);
+    else if (strcmp(self->check, "endless") == 0)
+        passed = VueHeadless_check_endless(self);
+    else if (strcmp(self->check, "snapshot") == 0)
+        passed = VueHeadless_check_snapshot(self);
+    else if (strcmp(self->check, "shards") == 0)
+        passed = VueHeadless_check_shards(self);
+    else if (strcmp(self->check, "map") == 0)
+        passed = VueHeadless_check_map(self);
+    else
+    {
+        debug_logf("Unknown check %s", self->check);
+        printf("unknown check %s\n", self->check);
+        return 1;
+    }
+    printf("check %s: %s\n", self->check, passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
+
+int VueHeadless_main(Vue *self)
+{
+    const VueHeadless *headless = (VueHeadless *)self;
+    Controller *controller = self->game->controller;
+
+    HeadlessInput *inputs = NULL;
+    int num_inputs = 0;
+    if (headless->write_map != NULL)
+    {
+        if (!VueHeadless_write_map(headless, headless->write_map))
+            return 1;
+        printf("map %s: %dx%d, %d spawns\n", headless->write_map, headless->width, headless->height,
+               headless->players);
+        return 0;
+    }
+    if (headless->script != NULL && !VueHeadless_load_script(headless->script, &inputs, &num_inputs))
+        return 1;
+
+    // the threads do not survive the fork of the shards, they are started after it
+    Shard shard;
+    const bool sharded = headless->shards > 1 && headless->check == NULL;
+    if (sharded && !VueHeadless_fork_shards(headless, headless->shards, &shard))
+    {
+        free(inputs);
+        return 1;
+    }
+    const bool printing = !sharded || shard.index == 0;
+    if (!Controller_set_threads(controller, headless->threads))
+    {
+        debug_log("Failed to start the threads");
+        if (sharded)
+            VueHeadless_join_shards(headless, &shard);
+        free(inputs);
+        return 1;
+    }
+    Controller_set_speed(controller, headless->speed);
+    Controller_set_storage(controller, headless->storage);
+    Controller_set_mode(controller, headless->mode, headless->trail_lifetime, headless->respawn_delay);
+    if (headless->check != NULL)
+    {
+        free(inputs);
+        return VueHeadless_check(headless);
+    }
+
+    int io = 0;
+    int played = 0;
+    long long total_ticks = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int match = 0; match < headless->matches; match++)
+    {
+        HeadlessMatch result;
+        if (!VueHeadless_play_match(headless, match, inputs, num_inputs, &result))
+        {
+            io = 1;
+            break;
+        }
+        played++;
+        total_ticks += result.ticks;
+
+        // the checksum of a shard only covers its strip
+        if (sharded && printing)
+            printf("match %d: %d ticks, %d alive\n", match + 1, result.ticks, result.alive);
+        else if (printing)
+            printf("match %d: %d ticks, %d alive, checksum %016llx\n", match + 1, result.ticks, result.alive,
+                   result.checksum);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (sharded)
+    {
+        Controller_set_threads(controller, 0);
+        VueHeadless_join_shards(headless, &shard);
+    }
+    const double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if (printing)
+        printf("%d matches, %lld ticks in %.3f s: %.0f ticks/s\n", played, total_ticks, seconds,
+               seconds > 0 ? (double)total_ticks / seconds : 0.0);
+    free(inputs);
+    return io;
+}
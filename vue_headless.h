@@ -0,0 +1,241 @@
+#ifndef VUE_HEADLESS_H
+#define VUE_HEADLESS_H
+
+#include <stdbool.h>
+
+#include "map.h"
+#include "model.h"
+#include "shard.h"
+#include "vue.h"
+
+#define HEADLESS_MATCHES_PROMPT "-matches"
+#define HEADLESS_TICKS_PROMPT "-ticks"
+#define HEADLESS_PLAYERS_PROMPT "-players"
+#define HEADLESS_WIDTH_PROMPT "-width"
+#define HEADLESS_HEIGHT_PROMPT "-height"
+#define HEADLESS_SPEED_PROMPT "-speed"
+#define HEADLESS_THREADS_PROMPT "-threads"
+#define HEADLESS_SEED_PROMPT "-seed"
+#define HEADLESS_SCRIPT_PROMPT "-script"
+#define HEADLESS_STORAGE_PROMPT "-storage"
+#define HEADLESS_CHECK_PROMPT "-check"
+#define HEADLESS_ENDLESS_PROMPT "-endless"
+#define HEADLESS_RESPAWN_PROMPT "-respawn"
+#define HEADLESS_SHARDS_PROMPT "-shards"
+#define HEADLESS_WRITE_MAP_PROMPT "-write-map"
+#define HEADLESS_DEFAULT_RESPAWN 10
+
+#define HEADLESS_DEFAULT_MATCHES 10
+#define HEADLESS_DEFAULT_TICKS 1000
+#define HEADLESS_DEFAULT_PLAYERS 4
+#define HEADLESS_DEFAULT_SIZE 100
+#define HEADLESS_TURN_CHANCE 16 // a bot turns once in this many updates, when it is not blocked
+#define HEADLESS_CHECK_SHARDS 4 // processes of the check of the shards, without the -shards option
+#define HEADLESS_CHECK_THREADS 4 // threads of the check of the threads, without the -threads option
+#define HEADLESS_MAP_BLOCK_CELLS 200 // cells of a generated map for each block of obstacles
+#define HEADLESS_MAP_BLOCK_SIZE 8 // largest width and height of a block of obstacles
+#define HEADLESS_MAP_CLEARANCE 8 // free cells in front of each spawn of a generated map
+#define HEADLESS_CHECK_RAYS 4096 // raycasts of the check of the maps
+
+// Input of a script, a line "<tick> <player> <up|down|left|right>", applied before the update of its tick
+typedef struct HeadlessInput {
+    int tick;
+    int player;
+    int direction;
+} HeadlessInput;
+
+// Result of a match
+typedef struct HeadlessMatch {
+    int ticks;
+    int alive;
+    unsigned long long checksum;
+} HeadlessMatch;
+
+// Simulation without any drawing, the matches run as fast as possible
+typedef struct VueHeadless {
+    Vue base;
+    int matches;
+    int ticks; // largest number of updates of a match
+    int players;
+    int width;
+    int height;
+    int speed;
+    int threads;
+    int shards; // processes simulating a strip of the game area each, 1 for a single process
+    unsigned long long seed; // seed of the bots, the same seed plays the same matches
+    const char *script; // path of the script of the inputs, NULL for bots
+    ModelStorage storage;
+    GameMode mode;
+    int trail_lifetime; // updates a wall lasts in endless mode, 0 for no limit
+    int respawn_delay; // updates before a dead player respawns in endless mode
+    const char *check; // name of the check to run instead of the matches, NULL for none
+    const char *write_map; // path of the map to generate instead of playing, NULL for none
+} VueHeadless;
+
+/**
+ * @brief Initialize the headless Vue from the arguments
+ * @param self The headless Vue
+ * @param argv String array of arguments
+ * @param argc Number of arguments
+ * @return True if the options are valid, false otherwise
+ */
+bool VueHeadless_init(VueHeadless *self, char **argv, const int argc);
+
+/**
+ * @brief Main function for the headless Vue, prints the number of updates per second
+ * @param self The Vue
+ */
+int VueHeadless_main(Vue *self);
+
+/**
+ * @brief Load the inputs of a script
+ * @param path The path of the script
+ * @param inputs The output inputs, to free
+ * @param count The output number of inputs
+ * @return True if the script was loaded, false otherwise
+ * @note The lines are in the order of the ticks, the empty lines and the lines starting with # are skipped
+ */
+bool VueHeadless_load_script(const char *path, HeadlessInput **inputs, int *count);
+
+/**
+ * @brief Start a match
+ * @param self The headless Vue
+ * @param match The index of the match
+ * @param random The output state of the random generator of the bots of the match
+ * @return True if the match started, false otherwise
+ */
+bool VueHeadless_start_match(const VueHeadless *self, const int match, unsigned long long *random);
+
+/**
+ * @brief Count the cells owned by a wall
+ * @param model The model
+ * @return The number of cells of the game area owned by a wall or a live trail
+ */
+int VueHeadless_count_cells(const Model *model);
+
+/**
+ * @brief Play a match
+ * @param self The headless Vue
+ * @param match The index of the match, it picks the moves of the bots
+ * @param inputs The inputs of the script, unused without a script
+ * @param num_inputs The number of inputs
+ * @param output The output result
+ * @return True if the match was played, false if it could not start
+ */
+bool VueHeadless_play_match(const VueHeadless *self, const int match, const HeadlessInput *inputs,
+                            const int num_inputs, HeadlessMatch *output);
+
+/**
+ * @brief Run a check of the game logic
+ * @param self The headless Vue
+ * @return 0 if the check passed, 1 otherwise
+ * @note The checks are run by ctest, see CMakeLists.txt
+ */
+int VueHeadless_check(const VueHeadless *self);
+
+/**
+ * @brief Check that the storages of the walls play the same matches
+ * @param self The headless Vue
+ * @return True if the checksums of the grid and of the segments storages are equal
+ */
+bool VueHeadless_check_storage(const VueHeadless *self);
+
+/**
+ * @brief Check that the threads play the same matches as the calling thread alone
+ * @param self The headless Vue
+ * @return True if the matches end with the same checksums and alive players with and without threads, in each storage
+ * @note The matches have at least CONTROLLER_PARALLEL_MIN_PLAYERS players, so that the threads evaluate them
+ */
+bool VueHeadless_check_threads(const VueHeadless *self);
+
+/**
+ * @brief Check the endless mode
+ * @param self The headless Vue
+ * @return True if the walls expire on time, free their cells, are compacted and the dead players respawn
+ */
+bool VueHeadless_check_endless(const VueHeadless *self);
+
+/**
+ * @brief Check the snapshots of the model
+ * @param self The headless Vue
+ * @return True if restoring a snapshot gives back the checksum, the walls and the cells of the game when it was
+ * taken, and the game then plays the same updates again
+ */
+bool VueHeadless_check_snapshot(const VueHeadless *self);
+
+/**
+ * @brief Fork the processes of the shards and give the controller its shard
+ * @param self The headless Vue
+ * @param num_shards The number of shards
+ * @param shard The output shard of the calling process
+ * @return True if the shards were forked, false otherwise
+ * @note The threads of the controller do not survive a fork, they must be started after it
+ */
+bool VueHeadless_fork_shards(const VueHeadless *self, const int num_shards, Shard *shard);
+
+/**
+ * @brief Take the shard back from the controller and close it, the first shard waits for the others to exit
+ * @param self The headless Vue
+ * @param shard The shard of the calling process
+ */
+void VueHeadless_join_shards(const VueHeadless *self, Shard *shard);
+
+/**
+ * @brief Check if a wall or the live trail of a player covers a cell
+ * @param model The model
+ * @param player The index of the player
+ * @param x The x position
+ * @param y The y position
+ * @return True if the cell is covered by the player, false otherwise
+ * @note A cell crossed by the walls of several players is owned by any of them: the segments storage gives the wall
+ * with the lowest index, and a shard does not add the walls out of its window, so its walls can be in another order
+ */
+bool VueHeadless_covers_cell(const Model *model, const int player, const int x, const int y);
+
+/**
+ * @brief Check that the shards play the same matches as a single process
+ * @param self The headless Vue
+ * @return True if the players and the cells of each shard are the ones of a single process at the end of each match
+ * @note The matches are played by a single process first, then by the shards. The shards after the first one exit
+ * in this function
+ */
+bool VueHeadless_check_shards(const VueHeadless *self);
+
+/**
+ * @brief Generate the obstacles and the spawns of a map
+ * @param self The headless Vue, the map has its size, its players and its seed
+ * @param cells The output cells by rows, 1 for an obstacle
+ * @param spawns The output spawns, one for each player
+ * @note The obstacles are random blocks, the spawns are spread over the middle row, facing up and down in turn, with
+ * free cells in front of them
+ */
+void VueHeadless_generate_map(const VueHeadless *self, unsigned char *cells, MapSpawn *spawns);
+
+/**
+ * @brief Generate a map and write it
+ * @param self The headless Vue
+ * @param path The path of the map file
+ * @return True if the map was written, false otherwise
+ */
+bool VueHeadless_write_map(const VueHeadless *self, const char *path);
+
+/**
+ * @brief Check the map files
+ * @param self The headless Vue
+ * @return True if a written map opens with its obstacles and its spawns, its raycasts and its runs find the same
+ * obstacles as a scan of the cells, and a match can be played on it
+ */
+bool VueHeadless_check_map(const VueHeadless *self);
+
+/**
+ * @brief Turn the players of the bots
+ * @param self The headless Vue
+ * @param random The state of the random numbers of the match
+ * @return True if the moves were played, false if they could not be shared with the other shards
+ * @note A bot keeps its direction while the next cell is free, and turns to a free cell otherwise. A roll is drawn for
+ * each alive player whatever the process. The bots all pick their turns before any is played. When sharded, each shard
+ * picks the moves of the players in its strip, where it knows the free cells, and the shards exchange them
+ */
+bool VueHeadless_play_bots(const VueHeadless *self, unsigned long long *random);
+
+#endif // VUE_HEADLESS_H
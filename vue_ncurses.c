@@ -122,29 +122,43 @@ void VueNCURSES_draw_window(NCURSESData *data)
     const int width_win = getmaxx(data->win) - 2;
     const int height_win = getmaxy(data->win) - 2;
 
+    // render the obstacles of the map, by runs of each row
+    const Map *map = Controller_get_map(data->self->game->controller);
+    for (int row = 0; map != NULL && row < map->height; row++)
+    {
+        int min_x, max_x;
+        for (int column = 0; Map_next_run(map, row, column, &min_x, &max_x); column = max_x + 1)
+        {
+            const int x = VueNCURSES_estimate(min_x, width, width_win);
+            const int y = VueNCURSES_estimate(row, height, height_win);
+            const int length = VueNCURSES_estimate(max_x + 1, width, width_win) - x;
+            mvwhline(data->win, y + 1, x + 1, '#', length > 0 ? length : 1);
+        }
+    }
+
     // render the walls
     const int wall_count = Controller_get_wall_count(data->self->game->controller);
     for (int i = 0; i < wall_count; i++)
     {
-        const Wall *wall = Controller_get_wall(data->self->game->controller, i);
-        if (wall->length <= 1)
+        const Wall wall = Controller_get_wall(data->self->game->controller, i);
+        if (wall.length <= 1)
             continue;
-        const int x = VueNCURSES_estimate(wall->x, width, width_win);
-        const int y = VueNCURSES_estimate(wall->y, height, height_win);
+        const int x = VueNCURSES_estimate(wall.x, width, width_win);
+        const int y = VueNCURSES_estimate(wall.y, height, height_win);
 
-        switch (wall->direction)
+        switch (wall.direction)
         {
         case DIRECTION_UP:
-            mvwvline(data->win, y + 1, x + 1, '|', wall->length);
+            mvwvline(data->win, y + 1, x + 1, '|', wall.length);
             break;
         case DIRECTION_LEFT:
-            mvwhline(data->win, y + 1, x + 1, '-', wall->length);
+            mvwhline(data->win, y + 1, x + 1, '-', wall.length);
             break;
         case DIRECTION_DOWN:
-            mvwvline(data->win, y - wall->length + 1, x + 1, '|', wall->length);
+            mvwvline(data->win, y - wall.length + 1, x + 1, '|', wall.length);
             break;
         case DIRECTION_RIGHT:
-            mvwhline(data->win, y + 1, x - wall->length + 1, '-', wall->length);
+            mvwhline(data->win, y + 1, x - wall.length + 1, '-', wall.length);
             break;
         default:;
         }
@@ -251,7 +265,7 @@ void VueNCURSES_loop(NCURSESData *data)
                 {
                     data->msg_text = "Game started!";
                     debug_log("Game started!");
-                    *data->start_date = time(NULL);
+                    *data->start_date = GameClock_now();
                 }
                 else
                 {
@@ -272,65 +286,65 @@ void VueNCURSES_loop(NCURSESData *data)
             // movement keys
             // arrow for player 0
             else if (ch[0] == 65 && ch[1] == 91 && ch[2] == 27 && playing) // Move player 0 UP
-                Controller_move_player(data->self->game->controller, 0, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 0, DIRECTION_UP);
             else if (ch[0] == 66 && ch[1] == 91 && ch[2] == 27 && playing) // Move player 0 DOWN
-                Controller_move_player(data->self->game->controller, 0, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 0, DIRECTION_DOWN);
             else if (ch[0] == 68 && ch[1] == 91 && ch[2] == 27 && playing) // Move player 0 LEFT
-                Controller_move_player(data->self->game->controller, 0, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 0, DIRECTION_LEFT);
             else if (ch[0] == 67 && ch[1] == 91 && ch[2] == 27 && playing) // Move player 0 RIGHT
-                Controller_move_player(data->self->game->controller, 0, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 0, DIRECTION_RIGHT);
             // zqsd for player 1
             else if (ch[0] == 'z' && playing) // Move player 1 UP
-                Controller_move_player(data->self->game->controller, 1, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 1, DIRECTION_UP);
             else if (ch[0] == 's' && playing) // Move player 1 DOWN
-                Controller_move_player(data->self->game->controller, 1, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 1, DIRECTION_DOWN);
             else if (ch[0] == 'q' && playing) // Move player 1 LEFT
-                Controller_move_player(data->self->game->controller, 1, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 1, DIRECTION_LEFT);
             else if (ch[0] == 'd' && playing) // Move player 1 RIGHT
-                Controller_move_player(data->self->game->controller, 1, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 1, DIRECTION_RIGHT);
             // ijkl for player 2
             else if (ch[0] == 'i' && playing) // Move player 2 UP
-                Controller_move_player(data->self->game->controller, 2, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 2, DIRECTION_UP);
             else if (ch[0] == 'k' && playing) // Move player 2 DOWN
-                Controller_move_player(data->self->game->controller, 2, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 2, DIRECTION_DOWN);
             else if (ch[0] == 'j' && playing) // Move player 2 LEFT
-                Controller_move_player(data->self->game->controller, 2, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 2, DIRECTION_LEFT);
             else if (ch[0] == 'l' && playing) // Move player 2 RIGHT
-                Controller_move_player(data->self->game->controller, 2, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 2, DIRECTION_RIGHT);
             // tfgh for player 3
             else if (ch[0] == 't' && playing) // Move player 3 UP
-                Controller_move_player(data->self->game->controller, 3, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 3, DIRECTION_UP);
             else if (ch[0] == 'g' && playing) // Move player 3 DOWN
-                Controller_move_player(data->self->game->controller, 3, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 3, DIRECTION_DOWN);
             else if (ch[0] == 'f' && playing) // Move player 3 LEFT
-                Controller_move_player(data->self->game->controller, 3, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 3, DIRECTION_LEFT);
             else if (ch[0] == 'h' && playing) // Move player 3 RIGHT
-                Controller_move_player(data->self->game->controller, 3, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 3, DIRECTION_RIGHT);
             // 5123 for player 4
             else if (ch[0] == '5' && playing) // Move player 4 UP
-                Controller_move_player(data->self->game->controller, 4, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 4, DIRECTION_UP);
             else if (ch[0] == '2' && playing) // Move player 4 DOWN
-                Controller_move_player(data->self->game->controller, 4, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 4, DIRECTION_DOWN);
             else if (ch[0] == '1' && playing) // Move player 4 LEFT
-                Controller_move_player(data->self->game->controller, 4, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 4, DIRECTION_LEFT);
             else if (ch[0] == '3' && playing) // Move player 4 RIGHT
-                Controller_move_player(data->self->game->controller, 4, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 4, DIRECTION_RIGHT);
             // -789 for player 5
             else if (ch[0] == '-' && playing) // Move player 5 UP
-                Controller_move_player(data->self->game->controller, 5, DIRECTION_UP);
+                Controller_queue_move(data->self->game->controller, 5, DIRECTION_UP);
             else if (ch[0] == '7' && playing) // Move player 5 DOWN
-                Controller_move_player(data->self->game->controller, 5, DIRECTION_DOWN);
+                Controller_queue_move(data->self->game->controller, 5, DIRECTION_DOWN);
             else if (ch[0] == '8' && playing) // Move player 5 LEFT
-                Controller_move_player(data->self->game->controller, 5, DIRECTION_LEFT);
+                Controller_queue_move(data->self->game->controller, 5, DIRECTION_LEFT);
             else if (ch[0] == '9' && playing) // Move player 5 RIGHT
-                Controller_move_player(data->self->game->controller, 5, DIRECTION_RIGHT);
+                Controller_queue_move(data->self->game->controller, 5, DIRECTION_RIGHT);
         } while (ch[0] != ERR);
 
         GameState state = Controller_get_state(data->self->game->controller);
 
         // calculate the time since the game started
-        const time_t crt = *data->start_date;
-        const long timer = time(NULL) - crt;
+        const long long crt = *data->start_date;
+        const long timer = (long)((GameClock_now() - crt) / GAME_CLOCK_SECOND);
 
         // comportment based on the game state
         if (state == GAME_STATE_PLAYING && timer >= DELAY)
@@ -343,9 +357,13 @@ void VueNCURSES_loop(NCURSESData *data)
                 wrefresh(data->msg);
             }
 
-            // update the game state
-            Controller_update(data->self->game->controller);
-            state = Controller_get_state(data->self->game->controller);
+            // run the updates due since the last frame, the game keeps its pace whatever the time spent drawing
+            const int steps = GameClock_advance(data->game_clock);
+            for (int i = 0; i < steps && state == GAME_STATE_PLAYING; i++)
+            {
+                Controller_update(data->self->game->controller);
+                state = Controller_get_state(data->self->game->controller);
+            }
 
             if (state == GAME_STATE_GAME_OVER)
             {
@@ -370,6 +388,9 @@ void VueNCURSES_loop(NCURSESData *data)
         }
         else if (state == GAME_STATE_PLAYING && timer == 0)
         {
+            GameClock_reset(data->game_clock);
+            Controller_clear_moves(data->self->game->controller);
+
             // clear the game preview and the scoreboard when the game starts
             wclear(data->win);
             box(data->win, 0, 0);
@@ -381,16 +402,20 @@ void VueNCURSES_loop(NCURSESData *data)
         else if (state == GAME_STATE_PLAYING)
         {
             // when the game is playing and the timeout is not over, show the countdown
+            GameClock_reset(data->game_clock);
+            Controller_clear_moves(data->self->game->controller);
             char msg[100];
             sprintf(msg, "Starting in %ld seconds...", DELAY - timer);
             data->msg_text = msg;
             wrefresh(data->msg);
         }
 
-        // render
+        // render, then wait for the next update or frame
         VueNCURSES_draw_window(data);
 
-        usleep(1000000 / GAME_FPS);
+        const long long frame = GAME_CLOCK_SECOND / RENDER_FPS;
+        const long long next = GameClock_until_next(data->game_clock);
+        usleep((useconds_t)((next < frame ? next : frame) / 1000));
     }
 }
 
@@ -410,10 +435,14 @@ int VueNCURSES_main(Vue *self)
     debug_log("VueNCURSES_main");
 
     // initialize the time since the game started
-    time_t *tim = malloc(sizeof(time_t));
+    long long *tim = malloc(sizeof(long long));
     if (tim == NULL)
         return 1;
-    *tim = time(NULL);
+    *tim = GameClock_now();
+
+    // the clock of the updates of the game
+    GameClock game_clock;
+    GameClock_init(&game_clock, GAME_FPS);
 
     NCURSESData data = {
         NULL,
@@ -421,7 +450,8 @@ int VueNCURSES_main(Vue *self)
         NULL,
         self,
         "Press * to start the game",
-        tim};
+        tim,
+        &game_clock};
 
     VueNCURSES_init(&data);
     VueNCURSES_loop(&data);
@@ -4,6 +4,7 @@
 #include <time.h>
 #include <ncurses.h>
 
+#include "game_clock.h"
 #include "vue.h"
 
 #define SAVED_KEYS 5
@@ -18,7 +19,8 @@ typedef struct NCURSESData {
     WINDOW *msg;
     Vue *self;
     char *msg_text;
-    time_t* start_date;
+    long long* start_date; // time of the start of the countdown, from GameClock_now
+    GameClock* game_clock; // updates of the game, at GAME_FPS whatever the time spent drawing
 } NCURSESData;
 
 /**
@@ -1,13 +1,19 @@
 #include "vue_sdl.h"
 
 #include <SDL2/SDL_ttf.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "tron.h"
 #include "utils.h"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 const SDL_Color COLOR_WHITE = {255, 255, 255, 255};
 const SDL_Color COLOR_BLACK = {0, 0, 0, 255};
 const SDL_Color COLOR_RED = {255, 0, 0, 255};
@@ -24,6 +30,8 @@ const SDL_Color COLOR_SECONDARY = {52, 52, 54, 255};
 const SDL_Color COLOR_BACKGROUND_SECONDARY = {44, 44, 46, 255};
 const SDL_Color COLOR_COLOR_SECONDARY = {171, 179, 182, 255};
 
+SDL_Color VueSDL_PALETTE[VUE_SDL_PALETTE_SIZE];
+
 const SDL_Keycode VueSDL_PLAYER_KEYS[MAX_PLAYERS][4] = {
     {SDLK_UP, SDLK_LEFT, SDLK_DOWN, SDLK_RIGHT},
     {SDLK_z, SDLK_q, SDLK_s, SDLK_d},
@@ -65,6 +73,63 @@ void VueSDL_box(SDLData* data, int x, int y, int w, int h, SDL_Color color)
     SDL_RenderFillRect(data->renderer, &rect);
 }
 
+void VueSDL_batch_box(SDLData* data, int x, int y, int w, int h, int color)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    VueSDL_BoxBatch* batch = &data->batches[color];
+    if (batch->count == batch->allocated)
+    {
+        const int allocated = batch->allocated > 0 ? batch->allocated * 2 : 256;
+        SDL_Rect* rects = realloc(batch->rects, allocated * sizeof(SDL_Rect));
+        if (rects == NULL)
+        {
+            // drawn right away, after the boxes of its color
+            debug_log("Failed to grow a batch of boxes");
+            VueSDL_flush_boxes(data);
+            VueSDL_box(data, x, y, w, h, VueSDL_PALETTE[color]);
+            return;
+        }
+        batch->rects = rects;
+        batch->allocated = allocated;
+    }
+    batch->rects[batch->count++] = (SDL_Rect){x, y, w, h};
+}
+
+void VueSDL_order_boxes(SDLData* data, int color)
+{
+    // the background covers the other colors, and the other colors cover the background
+    for (int i = 0; i < VUE_SDL_PALETTE_SIZE; i++)
+        if (data->batches[i].count > 0 && (i == VUE_SDL_PALETTE_BACKGROUND) != (color == VUE_SDL_PALETTE_BACKGROUND))
+        {
+            VueSDL_flush_boxes(data);
+            return;
+        }
+}
+
+void VueSDL_flush_boxes(SDLData* data)
+{
+    for (int i = 0; i < VUE_SDL_PALETTE_SIZE; i++)
+    {
+        VueSDL_BoxBatch* batch = &data->batches[i];
+        if (batch->count == 0)
+            continue;
+        const SDL_Color color = VueSDL_PALETTE[i];
+        SDL_SetRenderDrawColor(data->renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(data->renderer, batch->rects, batch->count);
+        batch->count = 0;
+    }
+}
+
+void VueSDL_destroy_batches(SDLData* data)
+{
+    for (int i = 0; i < VUE_SDL_PALETTE_SIZE; i++)
+    {
+        free(data->batches[i].rects);
+        data->batches[i] = (VueSDL_BoxBatch){NULL, 0, 0};
+    }
+}
+
 bool VueSDL_is_key_pressed(SDLData* data, SDL_Keycode key)
 {
     for (int i = 0; i < 4 * MAX_PLAYERS; i++)
@@ -73,60 +138,224 @@ bool VueSDL_is_key_pressed(SDLData* data, SDL_Keycode key)
     return false;
 }
 
-void VueSDL_label(SDLData* data, const char* text, int x, int y, SDL_Color color, int flags)
+SDL_Rect VueSDL_align(int x, int y, int w, int h, int flags)
 {
-    SDL_Surface* surface = TTF_RenderText_Solid(data->font, text, color);
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(data->renderer, surface);
-    SDL_Rect rect;
-
+    SDL_Rect rect = {x, y, w, h};
     if (flags & VueSDL_FLAG_LEFT)
-    {
         rect.x = x;
-        rect.y = y;
-        rect.w = surface->w;
-        rect.h = surface->h;
-    }
     else if (flags & VueSDL_FLAG_RIGHT)
+        rect.x = x - w;
+    else if (flags & VueSDL_FLAG_CENTER)
     {
-        rect.x = x - surface->w;
+        rect.x = x - w / 2;
+        rect.y = y - h / 2;
+    }
+    else if (flags & VueSDL_FLAG_TOP)
         rect.y = y;
-        rect.w = surface->w;
-        rect.h = surface->h;
+    else if (flags & VueSDL_FLAG_BOTTOM)
+        rect.y = y - h;
+    else if (flags & VueSDL_FLAG_MIDDLE)
+    {
+        rect.x = x - w / 2;
+        rect.y = y - h / 2;
     }
-    else if (flags & VueSDL_FLAG_CENTER)
+    return rect;
+}
+
+int VueSDL_glyph_index(char character)
+{
+    // the characters out of the atlas are drawn as a question mark
+    const int index = (unsigned char)character - VUE_SDL_GLYPH_FIRST;
+    return index >= 0 && index < VUE_SDL_GLYPH_COUNT ? index : '?' - VUE_SDL_GLYPH_FIRST;
+}
+
+bool VueSDL_build_atlas(SDLData* data)
+{
+    VueSDL_GlyphAtlas* atlas = &data->atlas;
+    atlas->texture = NULL;
+    atlas->height = TTF_FontHeight(data->font);
+
+    // the glyphs side by side, each as wide as its advance
+    int width = 0;
+    for (int i = 0; i < VUE_SDL_GLYPH_COUNT; i++)
     {
-        rect.x = x - surface->w / 2;
-        rect.y = y - surface->h / 2;
-        rect.w = surface->w;
-        rect.h = surface->h;
+        const char glyph[2] = {(char)(VUE_SDL_GLYPH_FIRST + i), '\0'};
+        int w = 0, h = 0;
+        if (TTF_SizeText(data->font, glyph, &w, &h) != 0)
+            w = 0;
+        atlas->glyphs[i] = (SDL_Rect){width, 0, w, atlas->height};
+        width += w;
     }
-    else if (flags & VueSDL_FLAG_TOP)
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, atlas->height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL)
     {
-        rect.x = x;
-        rect.y = y;
-        rect.w = surface->w;
-        rect.h = surface->h;
+        debug_log("Failed to create the glyph atlas");
+        return false;
     }
-    else if (flags & VueSDL_FLAG_BOTTOM)
+    for (int i = 0; i < VUE_SDL_GLYPH_COUNT; i++)
     {
-        rect.x = x;
-        rect.y = y - surface->h;
-        rect.w = surface->w;
-        rect.h = surface->h;
+        const char glyph[2] = {(char)(VUE_SDL_GLYPH_FIRST + i), '\0'};
+        if (atlas->glyphs[i].w == 0)
+            continue;
+        SDL_Surface* rendered = TTF_RenderText_Solid(data->font, glyph, COLOR_WHITE);
+        if (rendered == NULL)
+            continue;
+        SDL_Rect destination = atlas->glyphs[i];
+        SDL_BlitSurface(rendered, NULL, surface, &destination);
+        SDL_FreeSurface(rendered);
     }
-    else if (flags & VueSDL_FLAG_MIDDLE)
+
+    atlas->texture = SDL_CreateTextureFromSurface(data->renderer, surface);
+    SDL_FreeSurface(surface);
+    if (atlas->texture == NULL)
     {
-        rect.x = x - surface->w / 2;
-        rect.y = y - surface->h / 2;
-        rect.w = surface->w;
-        rect.h = surface->h;
+        debug_log("Failed to create the glyph atlas texture");
+        return false;
     }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    debug_logf("Glyph atlas: %dx%d", width, atlas->height);
+    return true;
+}
 
+void VueSDL_clear_labels(SDLData* data)
+{
+    for (int i = 0; i < VUE_SDL_LABEL_CACHE; i++)
+    {
+        if (data->labels.labels[i].texture != NULL)
+            SDL_DestroyTexture(data->labels.labels[i].texture);
+        memset(&data->labels.labels[i], 0, sizeof(VueSDL_Label));
+    }
+}
+
+void VueSDL_destroy_atlas(SDLData* data)
+{
+    VueSDL_clear_labels(data);
+    if (data->atlas.texture != NULL)
+        SDL_DestroyTexture(data->atlas.texture);
+    data->atlas.texture = NULL;
+}
+
+void VueSDL_measure_glyphs(SDLData* data, const char* text, int* w, int* h)
+{
+    *w = 0;
+    *h = data->atlas.height;
+    for (const char* c = text; *c != '\0'; c++)
+        *w += data->atlas.glyphs[VueSDL_glyph_index(*c)].w;
+}
+
+void VueSDL_draw_glyphs(SDLData* data, const char* text, int x, int y, SDL_Color color)
+{
+    SDL_SetTextureColorMod(data->atlas.texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(data->atlas.texture, color.a);
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        const SDL_Rect* glyph = &data->atlas.glyphs[VueSDL_glyph_index(*c)];
+        const SDL_Rect destination = {x, y, glyph->w, glyph->h};
+        SDL_RenderCopy(data->renderer, data->atlas.texture, glyph, &destination);
+        x += glyph->w;
+    }
+}
+
+const VueSDL_Label* VueSDL_get_label(SDLData* data, const char* text)
+{
+    const size_t length = strlen(text);
+    if (length == 0 || length >= VUE_SDL_LABEL_LENGTH || !SDL_RenderTargetSupported(data->renderer))
+        return NULL;
+
+    // FNV-1a, the text is only compared on a match of the hash
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+
+    // the cached label, or the least recently used one (the free ones were never used)
+    VueSDL_LabelCache* cache = &data->labels;
+    cache->uses++;
+    VueSDL_Label* oldest = &cache->labels[0];
+    for (int i = 0; i < VUE_SDL_LABEL_CACHE; i++)
+    {
+        VueSDL_Label* label = &cache->labels[i];
+        if (label->texture != NULL && label->hash == hash && strcmp(label->text, text) == 0)
+        {
+            label->last_used = cache->uses;
+            return label;
+        }
+        if (label->last_used < oldest->last_used)
+            oldest = label;
+    }
+
+    // render the label in white from the atlas, it is tinted when it is copied
+    int w, h;
+    VueSDL_measure_glyphs(data, text, &w, &h);
+    SDL_Texture* texture = SDL_CreateTexture(data->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (texture == NULL)
+        return NULL;
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    SDL_Texture* target = SDL_GetRenderTarget(data->renderer);
+    SDL_SetRenderTarget(data->renderer, texture);
+    SDL_SetRenderDrawColor(data->renderer, 0, 0, 0, 0);
+    SDL_RenderClear(data->renderer);
+    VueSDL_draw_glyphs(data, text, 0, 0, COLOR_WHITE);
+    SDL_SetRenderTarget(data->renderer, target);
+
+    if (oldest->texture != NULL)
+        SDL_DestroyTexture(oldest->texture);
+    memcpy(oldest->text, text, length + 1);
+    oldest->hash = hash;
+    oldest->texture = texture;
+    oldest->w = w;
+    oldest->h = h;
+    oldest->last_used = cache->uses;
+    return oldest;
+}
+
+void VueSDL_label(SDLData* data, const char* text, int x, int y, SDL_Color color, int flags)
+{
+    if (data->atlas.texture != NULL)
+    {
+        // a copy of the cached label, tinted with the color
+        const VueSDL_Label* label = VueSDL_get_label(data, text);
+        if (label != NULL)
+        {
+            const SDL_Rect rect = VueSDL_align(x, y, label->w, label->h, flags);
+            SDL_SetTextureColorMod(label->texture, color.r, color.g, color.b);
+            SDL_SetTextureAlphaMod(label->texture, color.a);
+            SDL_RenderCopy(data->renderer, label->texture, NULL, &rect);
+            return;
+        }
+
+        // a copy per glyph for the labels that cannot be cached
+        int w, h;
+        VueSDL_measure_glyphs(data, text, &w, &h);
+        const SDL_Rect rect = VueSDL_align(x, y, w, h, flags);
+        VueSDL_draw_glyphs(data, text, rect.x, rect.y, color);
+        return;
+    }
+
+    // without the atlas, the label is rendered by SDL_ttf
+    SDL_Surface* surface = TTF_RenderText_Solid(data->font, text, color);
+    if (surface == NULL)
+        return;
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(data->renderer, surface);
+    const SDL_Rect rect = VueSDL_align(x, y, surface->w, surface->h, flags);
     SDL_RenderCopy(data->renderer, texture, NULL, &rect);
     SDL_FreeSurface(surface);
     SDL_DestroyTexture(texture);
 }
 
+void VueSDL_dynamic_label(SDLData* data, const char* text, int x, int y, SDL_Color color, int flags)
+{
+    if (data->atlas.texture == NULL)
+    {
+        VueSDL_label(data, text, x, y, color, flags);
+        return;
+    }
+    int w, h;
+    VueSDL_measure_glyphs(data, text, &w, &h);
+    const SDL_Rect rect = VueSDL_align(x, y, w, h, flags);
+    VueSDL_draw_glyphs(data, text, rect.x, rect.y, color);
+}
+
 bool VueSDL_slider(SDLData* data, int x, int y, int w, int h, int* value, SDL_Color background, SDL_Color select,
                    int min, int max)
 {
@@ -326,8 +555,9 @@ int VueSDL_init(SDLData* data)
         return 1;
     }
 
-    // create renderer
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // create renderer, the software path draws the game in its framebuffer
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1,
+                                                data->software ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
     if (renderer == NULL)
     {
         debug_log("SDL_CreateRenderer failed");
@@ -345,6 +575,11 @@ int VueSDL_init(SDLData* data)
     data->window = window;
     data->renderer = renderer;
 
+    // the labels are copied from the glyph atlas, or rendered by SDL_ttf without it
+    VueSDL_build_atlas(data);
+    VueSDL_build_palette();
+    VueSDL_reset_camera(data);
+
     // add the minimum number of players
     while (Controller_get_player_count(data->self->game->controller) < MIN_PLAYER)
         Controller_new_player(data->self->game->controller);
@@ -372,38 +607,58 @@ char* VueSDL_get_color_text(int player)
     return "Unknown";
 }
 
-SDL_Color VueSDL_get_color_value(int player)
+void VueSDL_build_palette(void)
 {
-    SDL_Color color = COLOR_WHITE;
-    switch (player)
+    for (int player = 0; player <= VUE_SDL_PALETTE_OTHER; player++)
     {
-    case 0:
-        color = COLOR_RED;
-        break;
-    case 1:
-        color = COLOR_GREEN;
-        break;
-    case 2:
-        color = COLOR_BLUE;
-        break;
-    case 3:
-        color = COLOR_YELLOW;
-        break;
-    case 4:
-        color = COLOR_CYAN;
-        break;
-    case 5:
-        color = COLOR_MAGENTA;
-        break;
+        SDL_Color color = COLOR_WHITE;
+        switch (player)
+        {
+        case 0:
+            color = COLOR_RED;
+            break;
+        case 1:
+            color = COLOR_GREEN;
+            break;
+        case 2:
+            color = COLOR_BLUE;
+            break;
+        case 3:
+            color = COLOR_YELLOW;
+            break;
+        case 4:
+            color = COLOR_CYAN;
+            break;
+        case 5:
+            color = COLOR_MAGENTA;
+            break;
+        }
+        VueSDL_mix_color(&VueSDL_PALETTE[player], &COLOR_BLACK, &color, .5f);
+        VueSDL_PALETTE[player].a = color.a;
     }
-    VueSDL_mix_color(&color, &COLOR_BLACK, &color, .5f);
-    return color;
+    VueSDL_PALETTE[VUE_SDL_PALETTE_OBSTACLE] = COLOR_COLOR_PRIMARY;
+    VueSDL_PALETTE[VUE_SDL_PALETTE_BACKGROUND] = COLOR_BACKGROUND_PRIMARY;
+}
+
+int VueSDL_get_palette_index(int player)
+{
+    return player >= 0 && player < MAX_PLAYERS ? player : VUE_SDL_PALETTE_OTHER;
+}
+
+SDL_Color VueSDL_get_color_value(int player)
+{
+    return VueSDL_PALETTE[VueSDL_get_palette_index(player)];
 }
 
 
 void VueSDL_destroy(SDLData* data)
 {
     debug_log("VueSDL_destroy");
+    VueSDL_destroy_atlas(data);
+    VueSDL_destroy_trails(data);
+    VueSDL_destroy_batches(data);
+    VueSDL_destroy_cells(data);
+    VueSDL_destroy_framebuffer(data);
     SDL_DestroyRenderer(data->renderer);
     SDL_DestroyWindow(data->window);
     TTF_CloseFont(data->font);
@@ -543,6 +798,539 @@ void VueSDL_option_menu(SDLData* data)
 }
 
 
+void VueSDL_wall_cells(const Wall* wall, SDL_Rect* cells)
+{
+    switch (wall->direction)
+    {
+    case DIRECTION_UP:
+        *cells = (SDL_Rect){wall->x, wall->y, 1, wall->length};
+        break;
+    case DIRECTION_DOWN:
+        *cells = (SDL_Rect){wall->x, wall->y - wall->length + 1, 1, wall->length};
+        break;
+    case DIRECTION_LEFT:
+        *cells = (SDL_Rect){wall->x, wall->y, wall->length, 1};
+        break;
+    case DIRECTION_RIGHT:
+        *cells = (SDL_Rect){wall->x - wall->length + 1, wall->y, wall->length, 1};
+        break;
+    default:
+        *cells = (SDL_Rect){wall->x, wall->y, 0, 0};
+        break;
+    }
+}
+
+void VueSDL_draw_wall(SDLData* data, const Wall* wall, int x, int cell_w, int cell_h, int color)
+{
+    SDL_Rect cells;
+    VueSDL_wall_cells(wall, &cells);
+    VueSDL_batch_box(data, x + cells.x * cell_w, cells.y * cell_h, cells.w * cell_w, cells.h * cell_h, color);
+}
+
+void VueSDL_draw_walls(SDLData* data, int x, int cell_w, int cell_h)
+{
+    // obstacles of the map, by runs of each row
+    const Map* map = Controller_get_map(data->self->game->controller);
+    for (int row = 0; map != NULL && row < map->height; row++)
+    {
+        int min_x, max_x;
+        for (int column = 0; Map_next_run(map, row, column, &min_x, &max_x); column = max_x + 1)
+            VueSDL_batch_box(data, x + min_x * cell_w, row * cell_h, (max_x - min_x + 1) * cell_w, cell_h,
+                             VUE_SDL_PALETTE_OBSTACLE);
+    }
+
+    // walls, the removed ones are empty
+    int wall_count = Controller_get_wall_count(data->self->game->controller);
+    for (int i = 0; i < wall_count; i++)
+    {
+        const Wall wall = Controller_get_wall(data->self->game->controller, i);
+        if (wall.length > 0)
+            VueSDL_draw_wall(data, &wall, x, cell_w, cell_h, VueSDL_get_palette_index(wall.player));
+    }
+}
+
+void VueSDL_destroy_trails(SDLData* data)
+{
+    if (data->trails.texture != NULL)
+        SDL_DestroyTexture(data->trails.texture);
+    data->trails.texture = NULL;
+}
+
+bool VueSDL_update_trails(SDLData* data, int cell_w, int cell_h)
+{
+    VueSDL_TrailLayer* layer = &data->trails;
+    Controller* controller = data->self->game->controller;
+    const int width = Controller_get_width(controller);
+    const int height = Controller_get_height(controller);
+    if (cell_w <= 0 || cell_h <= 0 || width <= 0 || height <= 0 || !SDL_RenderTargetSupported(data->renderer))
+        return false;
+
+    // a new texture for a new size of the game area
+    if (layer->texture == NULL || layer->cell_w != cell_w || layer->cell_h != cell_h || layer->width != width
+        || layer->height != height)
+    {
+        VueSDL_destroy_trails(data);
+        layer->texture = SDL_CreateTexture(data->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                           width * cell_w, height * cell_h);
+        if (layer->texture == NULL)
+        {
+            debug_log("Failed to create the trail layer");
+            return false;
+        }
+        layer->cell_w = cell_w;
+        layer->cell_h = cell_h;
+        layer->width = width;
+        layer->height = height;
+        layer->dirty = true;
+    }
+
+    SDL_Texture* target = SDL_GetRenderTarget(data->renderer);
+    SDL_SetRenderTarget(data->renderer, layer->texture);
+
+    // the walls changed since the last frame
+    Event event;
+    EventReadResult result;
+    while (!layer->dirty && (result = Controller_read_event(controller, &layer->cursor, &event)) != EVENT_READ_EMPTY)
+    {
+        const Wall wall = {event.x, event.y, event.direction, event.value, event.player};
+        if (result == EVENT_READ_OVERRUN || event.type == EVENT_WALLS_CLEARED || event.type == EVENT_RESTORED)
+            layer->dirty = true;
+        else if (event.type == EVENT_WALL_ADDED || event.type == EVENT_WALL_EXTENDED)
+        {
+            VueSDL_order_boxes(data, VueSDL_get_palette_index(wall.player));
+            VueSDL_draw_wall(data, &wall, 0, cell_w, cell_h, VueSDL_get_palette_index(wall.player));
+        }
+        else if (event.type == EVENT_WALL_REMOVED)
+        {
+            VueSDL_order_boxes(data, VUE_SDL_PALETTE_BACKGROUND);
+            VueSDL_draw_wall(data, &wall, 0, cell_w, cell_h, VUE_SDL_PALETTE_BACKGROUND);
+        }
+    }
+
+    // or the whole game area, the model does not change while the frame is drawn
+    if (layer->dirty)
+    {
+        // the boxes of the events before the rebuild are dropped
+        for (int i = 0; i < VUE_SDL_PALETTE_SIZE; i++)
+            data->batches[i].count = 0;
+        layer->cursor = Controller_get_event_cursor(controller);
+        SDL_SetRenderDrawColor(data->renderer, COLOR_BACKGROUND_PRIMARY.r, COLOR_BACKGROUND_PRIMARY.g,
+                               COLOR_BACKGROUND_PRIMARY.b, COLOR_BACKGROUND_PRIMARY.a);
+        SDL_RenderClear(data->renderer);
+        VueSDL_draw_walls(data, 0, cell_w, cell_h);
+        layer->dirty = false;
+    }
+
+    VueSDL_flush_boxes(data);
+    SDL_SetRenderTarget(data->renderer, target);
+    return true;
+}
+
+void VueSDL_destroy_cells(SDLData* data)
+{
+    VueSDL_CellLayer* layer = &data->cells;
+    if (layer->texture != NULL)
+        SDL_DestroyTexture(layer->texture);
+    free(layer->pixels);
+    free(layer->dirty_rows);
+    layer->texture = NULL;
+    layer->pixels = NULL;
+    layer->dirty_rows = NULL;
+    layer->width = 0;
+    layer->height = 0;
+}
+
+Uint32 VueSDL_pack_color(SDL_Color color)
+{
+    return (Uint32)color.a << 24 | (Uint32)color.r << 16 | (Uint32)color.g << 8 | color.b;
+}
+
+void VueSDL_fill_row(Uint32* row, int count, Uint32 pixel)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    // 8 pixels at a time
+    const __m256i pixels = _mm256_set1_epi32((int)pixel);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256((__m256i*)&row[i], pixels);
+#elif defined(__SSE2__)
+    // 4 pixels at a time
+    const __m128i pixels = _mm_set1_epi32((int)pixel);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)&row[i], pixels);
+#endif
+
+    // scalar fallback, and the remaining pixels
+    for (; i < count; i++)
+        row[i] = pixel;
+}
+
+void VueSDL_fill_cells(VueSDL_CellLayer* layer, const SDL_Rect* cells, SDL_Color color)
+{
+    const int min_x = cells->x > 0 ? cells->x : 0;
+    const int max_x = cells->x + cells->w < layer->width ? cells->x + cells->w : layer->width;
+    const int min_y = cells->y > 0 ? cells->y : 0;
+    const int max_y = cells->y + cells->h < layer->height ? cells->y + cells->h : layer->height;
+    if (min_x >= max_x || min_y >= max_y)
+        return;
+
+    const Uint32 pixel = VueSDL_pack_color(color);
+    for (int y = min_y; y < max_y; y++)
+    {
+        VueSDL_fill_row(layer->pixels + (size_t)y * layer->width + min_x, max_x - min_x, pixel);
+        layer->dirty_rows[y] = true;
+    }
+}
+
+bool VueSDL_update_cells(SDLData* data)
+{
+    VueSDL_CellLayer* layer = &data->cells;
+    Controller* controller = data->self->game->controller;
+    const int width = Controller_get_width(controller);
+    const int height = Controller_get_height(controller);
+    if (width <= 0 || height <= 0)
+        return false;
+
+    // a new texture for a new size of the game area, it fails when the game area is larger than the textures
+    if (layer->pixels == NULL || layer->width != width || layer->height != height)
+    {
+        VueSDL_destroy_cells(data);
+        // the software path reads the pixels, without the texture
+        if (!data->software)
+        {
+            layer->texture = SDL_CreateTexture(data->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                               width, height);
+            if (layer->texture == NULL)
+                return false;
+        }
+        layer->pixels = malloc((size_t)width * height * sizeof(Uint32));
+        layer->dirty_rows = calloc(height, sizeof(bool));
+        if (layer->pixels == NULL || layer->dirty_rows == NULL)
+        {
+            debug_log("Failed to allocate the cell layer");
+            VueSDL_destroy_cells(data);
+            return false;
+        }
+        layer->width = width;
+        layer->height = height;
+        layer->dirty = true;
+    }
+
+    // the walls changed since the last frame
+    Event event;
+    EventReadResult result;
+    while (!layer->dirty && (result = Controller_read_event(controller, &layer->cursor, &event)) != EVENT_READ_EMPTY)
+    {
+        const Wall wall = {event.x, event.y, event.direction, event.value, event.player};
+        SDL_Rect cells;
+        VueSDL_wall_cells(&wall, &cells);
+        if (result == EVENT_READ_OVERRUN || event.type == EVENT_WALLS_CLEARED || event.type == EVENT_RESTORED)
+            layer->dirty = true;
+        else if (event.type == EVENT_WALL_ADDED || event.type == EVENT_WALL_EXTENDED)
+            VueSDL_fill_cells(layer, &cells, VueSDL_PALETTE[VueSDL_get_palette_index(wall.player)]);
+        else if (event.type == EVENT_WALL_REMOVED)
+            VueSDL_fill_cells(layer, &cells, COLOR_BACKGROUND_PRIMARY);
+    }
+
+    // or the whole game area
+    if (layer->dirty)
+    {
+        layer->cursor = Controller_get_event_cursor(controller);
+        const SDL_Rect area = {0, 0, width, height};
+        VueSDL_fill_cells(layer, &area, COLOR_BACKGROUND_PRIMARY);
+
+        const Map* map = Controller_get_map(controller);
+        for (int row = 0; map != NULL && row < map->height; row++)
+        {
+            int min_x, max_x;
+            for (int column = 0; Map_next_run(map, row, column, &min_x, &max_x); column = max_x + 1)
+            {
+                const SDL_Rect run = {min_x, row, max_x - min_x + 1, 1};
+                VueSDL_fill_cells(layer, &run, COLOR_COLOR_PRIMARY);
+            }
+        }
+
+        int wall_count = Controller_get_wall_count(controller);
+        for (int i = 0; i < wall_count; i++)
+        {
+            const Wall wall = Controller_get_wall(controller, i);
+            SDL_Rect cells;
+            VueSDL_wall_cells(&wall, &cells);
+            if (wall.length > 0)
+                VueSDL_fill_cells(layer, &cells, VueSDL_PALETTE[VueSDL_get_palette_index(wall.player)]);
+        }
+        layer->dirty = false;
+    }
+
+    // upload the runs of changed rows
+    for (int y = 0; y < height; y++)
+    {
+        if (!layer->dirty_rows[y])
+            continue;
+        int end = y;
+        while (end < height && layer->dirty_rows[end])
+            layer->dirty_rows[end++] = false;
+        const SDL_Rect rows = {0, y, width, end - y};
+        if (layer->texture != NULL)
+            SDL_UpdateTexture(layer->texture, &rows, layer->pixels + (size_t)y * width, width * (int)sizeof(Uint32));
+        y = end;
+    }
+    return true;
+}
+
+void VueSDL_clamp_camera(SDLData* data)
+{
+    // the viewport stays in the game area
+    VueSDL_Camera* camera = &data->camera;
+    const float width = (float)Controller_get_width(data->self->game->controller);
+    const float height = (float)Controller_get_height(data->self->game->controller);
+    camera->zoom = camera->zoom < 1.f ? 1.f : camera->zoom > VUE_SDL_MAX_ZOOM ? VUE_SDL_MAX_ZOOM : camera->zoom;
+    const float half_w = width / (2 * camera->zoom);
+    const float half_h = height / (2 * camera->zoom);
+    camera->x = camera->x < half_w ? half_w : camera->x > width - half_w ? width - half_w : camera->x;
+    camera->y = camera->y < half_h ? half_h : camera->y > height - half_h ? height - half_h : camera->y;
+}
+
+void VueSDL_reset_camera(SDLData* data)
+{
+    data->camera.zoom = 1.f;
+    data->camera.x = (float)Controller_get_width(data->self->game->controller) / 2;
+    data->camera.y = (float)Controller_get_height(data->self->game->controller) / 2;
+}
+
+void VueSDL_get_view(SDLData* data, VueSDL_View* view)
+{
+    int w, h;
+    SDL_GetWindowSize(data->window, &w, &h);
+    const int width = Controller_get_width(data->self->game->controller);
+    const int height = Controller_get_height(data->self->game->controller);
+    const float zoom = data->camera.zoom;
+
+    view->viewport = (SDL_Rect){SCOREBOARD_WIDTH, 0, w - SCOREBOARD_WIDTH, h};
+    view->scale_x = width > 0 ? (float)view->viewport.w / (float)width * zoom : 1.f;
+    view->scale_y = height > 0 ? (float)view->viewport.h / (float)height * zoom : 1.f;
+    view->left = data->camera.x - (float)width / (2 * zoom);
+    view->top = data->camera.y - (float)height / (2 * zoom);
+}
+
+void VueSDL_zoom_camera(SDLData* data, float factor, int mouse_x, int mouse_y)
+{
+    VueSDL_View view;
+    VueSDL_get_view(data, &view);
+    const float cell_x = view.left + (float)(mouse_x - view.viewport.x) / view.scale_x;
+    const float cell_y = view.top + (float)(mouse_y - view.viewport.y) / view.scale_y;
+
+    data->camera.zoom *= factor;
+    VueSDL_clamp_camera(data);
+
+    // move the cell that went under the mouse back to the cell that was under it
+    VueSDL_get_view(data, &view);
+    data->camera.x += cell_x - (view.left + (float)(mouse_x - view.viewport.x) / view.scale_x);
+    data->camera.y += cell_y - (view.top + (float)(mouse_y - view.viewport.y) / view.scale_y);
+    VueSDL_clamp_camera(data);
+}
+
+void VueSDL_pan_camera(SDLData* data, int dx, int dy)
+{
+    VueSDL_View view;
+    VueSDL_get_view(data, &view);
+    data->camera.x -= (float)dx / view.scale_x;
+    data->camera.y -= (float)dy / view.scale_y;
+    VueSDL_clamp_camera(data);
+}
+
+void VueSDL_view_rect(const VueSDL_View* view, const SDL_Rect* cells, SDL_Rect* rect)
+{
+    const int x0 = (int)floorf(((float)cells->x - view->left) * view->scale_x);
+    const int y0 = (int)floorf(((float)cells->y - view->top) * view->scale_y);
+    const int x1 = (int)floorf(((float)(cells->x + cells->w) - view->left) * view->scale_x);
+    const int y1 = (int)floorf(((float)(cells->y + cells->h) - view->top) * view->scale_y);
+    rect->x = view->viewport.x + x0;
+    rect->y = view->viewport.y + y0;
+    rect->w = x1 > x0 ? x1 - x0 : 1;
+    rect->h = y1 > y0 ? y1 - y0 : 1;
+}
+
+void VueSDL_visible_cells(const VueSDL_View* view, int width, int height, SDL_Rect* cells)
+{
+    const int min_x = view->left > 0 ? (int)view->left : 0;
+    const int min_y = view->top > 0 ? (int)view->top : 0;
+    const int max_x = (int)ceilf(view->left + (float)view->viewport.w / view->scale_x);
+    const int max_y = (int)ceilf(view->top + (float)view->viewport.h / view->scale_y);
+    *cells = (SDL_Rect){min_x, min_y, (max_x < width ? max_x : width) - min_x, (max_y < height ? max_y : height) - min_y};
+}
+
+void VueSDL_view_box(SDLData* data, const VueSDL_View* view, const SDL_Rect* cells, int color)
+{
+    if (cells->w <= 0 || cells->h <= 0)
+        return;
+    SDL_Rect rect, visible;
+    VueSDL_view_rect(view, cells, &rect);
+    if (SDL_IntersectRect(&rect, &view->viewport, &visible))
+        VueSDL_batch_box(data, visible.x, visible.y, visible.w, visible.h, color);
+}
+
+void VueSDL_view_walls(SDLData* data, const VueSDL_View* view)
+{
+    Controller* controller = data->self->game->controller;
+    SDL_Rect visible;
+    VueSDL_visible_cells(view, Controller_get_width(controller), Controller_get_height(controller), &visible);
+
+    // obstacles of the rows of the viewport
+    const Map* map = Controller_get_map(controller);
+    for (int row = visible.y; map != NULL && row < visible.y + visible.h && row < map->height; row++)
+    {
+        int min_x, max_x;
+        for (int column = visible.x; Map_next_run(map, row, column, &min_x, &max_x) && min_x < visible.x + visible.w;
+             column = max_x + 1)
+        {
+            const SDL_Rect run = {min_x, row, max_x - min_x + 1, 1};
+            VueSDL_view_box(data, view, &run, VUE_SDL_PALETTE_OBSTACLE);
+        }
+    }
+
+    // walls, the ones outside of the viewport are culled
+    int wall_count = Controller_get_wall_count(controller);
+    for (int i = 0; i < wall_count; i++)
+    {
+        const Wall wall = Controller_get_wall(controller, i);
+        SDL_Rect cells;
+        VueSDL_wall_cells(&wall, &cells);
+        if (wall.length > 0)
+            VueSDL_view_box(data, view, &cells, VueSDL_get_palette_index(wall.player));
+    }
+}
+
+void VueSDL_map_cells(int* map, int pixels, float first, float scale, int cells)
+{
+    for (int p = 0; p < pixels; p++)
+        map[p] = -1;
+
+    // the pixels of each cell, as in VueSDL_view_rect
+    for (int c = first > 0 ? (int)first : 0; c < cells; c++)
+    {
+        const int p0 = (int)floorf(((float)c - first) * scale);
+        const int p1 = (int)floorf(((float)(c + 1) - first) * scale);
+        if (p0 >= pixels)
+            break;
+        for (int p = p0 > 0 ? p0 : 0; p < p1 && p < pixels; p++)
+            map[p] = c;
+    }
+}
+
+void VueSDL_destroy_framebuffer(SDLData* data)
+{
+    VueSDL_Framebuffer* framebuffer = &data->framebuffer;
+    if (framebuffer->surface != NULL)
+        SDL_FreeSurface(framebuffer->surface);
+    if (framebuffer->texture != NULL)
+        SDL_DestroyTexture(framebuffer->texture);
+    free(framebuffer->columns);
+    free(framebuffer->rows);
+    *framebuffer = (VueSDL_Framebuffer){NULL, NULL, NULL, NULL};
+}
+
+void VueSDL_software_box(SDLData* data, const VueSDL_View* view, const SDL_Rect* cells, Uint32 pixel)
+{
+    if (cells->w <= 0 || cells->h <= 0)
+        return;
+    SDL_Rect rect, visible;
+    VueSDL_view_rect(view, cells, &rect);
+    if (!SDL_IntersectRect(&rect, &view->viewport, &visible))
+        return;
+
+    const SDL_Surface* surface = data->framebuffer.surface;
+    Uint32* pixels = (Uint32*)surface->pixels + (visible.x - view->viewport.x);
+    const int stride = surface->pitch / (int)sizeof(Uint32);
+    for (int y = visible.y - view->viewport.y; y < visible.y - view->viewport.y + visible.h; y++)
+        VueSDL_fill_row(pixels + (size_t)y * stride, visible.w, pixel);
+}
+
+bool VueSDL_render_software(SDLData* data, const VueSDL_View* view)
+{
+    VueSDL_Framebuffer* framebuffer = &data->framebuffer;
+    Controller* controller = data->self->game->controller;
+    const int w = view->viewport.w;
+    const int h = view->viewport.h;
+    if (w <= 0 || h <= 0 || !VueSDL_update_cells(data))
+        return false;
+
+    // a new framebuffer for a new size of the viewport
+    if (framebuffer->surface == NULL || framebuffer->surface->w != w || framebuffer->surface->h != h)
+    {
+        VueSDL_destroy_framebuffer(data);
+        framebuffer->surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+        framebuffer->texture = SDL_CreateTexture(data->renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                 SDL_TEXTUREACCESS_STREAMING, w, h);
+        framebuffer->columns = malloc(w * sizeof(int));
+        framebuffer->rows = malloc(h * sizeof(int));
+        if (framebuffer->surface == NULL || framebuffer->texture == NULL || framebuffer->columns == NULL
+            || framebuffer->rows == NULL)
+        {
+            debug_log("Failed to create the framebuffer");
+            VueSDL_destroy_framebuffer(data);
+            return false;
+        }
+    }
+
+    // cells of the pixels
+    const VueSDL_CellLayer* layer = &data->cells;
+    VueSDL_map_cells(framebuffer->columns, w, view->left, view->scale_x, layer->width);
+    VueSDL_map_cells(framebuffer->rows, h, view->top, view->scale_y, layer->height);
+
+    // rows of pixels, by spans of the same color
+    const Uint32 background = VueSDL_pack_color(COLOR_BACKGROUND_PRIMARY);
+    const int* columns = framebuffer->columns;
+    const int stride = framebuffer->surface->pitch / (int)sizeof(Uint32);
+    Uint32* pixels = framebuffer->surface->pixels;
+    for (int y = 0; y < h; y++)
+    {
+        Uint32* row = pixels + (size_t)y * stride;
+        const int cell_y = framebuffer->rows[y];
+        if (y > 0 && cell_y == framebuffer->rows[y - 1])
+        {
+            memcpy(row, row - stride, w * sizeof(Uint32));
+            continue;
+        }
+
+        const Uint32* cells = cell_y >= 0 ? layer->pixels + (size_t)cell_y * layer->width : NULL;
+        for (int x = 0; x < w;)
+        {
+            const int start = x;
+            const Uint32 pixel = cells != NULL && columns[x] >= 0 ? cells[columns[x]] : background;
+            while (x < w && (cells != NULL && columns[x] >= 0 ? cells[columns[x]] : background) == pixel)
+                x++;
+            VueSDL_fill_row(row + start, x - start, pixel);
+        }
+    }
+
+    // player_walls, then the players over the walls of the others
+    const int player_count = Controller_get_player_count(controller);
+    Wall wall;
+    int distance;
+    for (int i = 0; i < player_count; i++)
+    {
+        Controller_get_player_wall(controller, i, &wall, &distance);
+        const Player* player = Controller_get_player(controller, i);
+        const Wall segment = {player->x, player->y, player->direction, distance, i};
+        SDL_Rect cells;
+        VueSDL_wall_cells(&segment, &cells);
+        VueSDL_software_box(data, view, &cells, VueSDL_pack_color(VueSDL_get_color_value(i)));
+    }
+    for (int i = 0; i < player_count; i++)
+    {
+        const Player* player = Controller_get_player(controller, i);
+        const SDL_Rect cells = {player->x, player->y, 1, 1};
+        VueSDL_software_box(data, view, &cells, VueSDL_pack_color(VueSDL_get_color_value(i)));
+    }
+
+    // a single copy to the window
+    SDL_UpdateTexture(framebuffer->texture, NULL, pixels, framebuffer->surface->pitch);
+    SDL_RenderCopy(data->renderer, framebuffer->texture, NULL, &view->viewport);
+    return true;
+}
+
 void VueSDL_render_game(SDLData* data)
 {
     int w, h;
@@ -574,7 +1362,7 @@ void VueSDL_render_game(SDLData* data)
         colorValue = VueSDL_get_color_value(player_scores[i][0]);
         VueSDL_box(data, 10, 50 + i * 40, SCOREBOARD_WIDTH - 20, 30, colorValue);
         sprintf(msg, player->state == PLAYER_STATE_DEAD ? "%d X %d" : "%d - %d", i + 1, player_scores[i][1]);
-        VueSDL_label(data, msg, SCOREBOARD_WIDTH / 2, 64 + i * 40, COLOR_COLOR_PRIMARY, VueSDL_FLAG_CENTER);
+        VueSDL_dynamic_label(data, msg, SCOREBOARD_WIDTH / 2, 64 + i * 40, COLOR_COLOR_PRIMARY, VueSDL_FLAG_CENTER);
     }
 
     // game grid
@@ -583,69 +1371,66 @@ void VueSDL_render_game(SDLData* data)
     int cell_w = (w - SCOREBOARD_WIDTH) / width;
     int cell_h = h / height;
 
-    // walls
-    int wall_count = Controller_get_wall_count(data->self->game->controller);
-    for (int i = 0; i < wall_count; i++)
+    // the cells of the trail layer, or of the cell layer for the small cells and the zoomed camera
+    VueSDL_View view;
+    const bool trails = data->camera.zoom <= 1.f && cell_w >= VUE_SDL_MIN_CELL && cell_h >= VUE_SDL_MIN_CELL;
+    if (trails)
+        view = (VueSDL_View){{SCOREBOARD_WIDTH, 0, width * cell_w, height * cell_h}, 0, 0, (float)cell_w,
+                             (float)cell_h};
+    else
+        VueSDL_get_view(data, &view);
+
+    // the whole game area drawn on the CPU
+    if (data->software && VueSDL_render_software(data, &view))
+        return;
+
+    // walls and obstacles, a copy of the trail layer
+    if (trails)
     {
-        Wall* wall = Controller_get_wall(data->self->game->controller, i);
-        SDL_Color color = VueSDL_get_color_value(wall->player);
-        switch (wall->direction)
+        if (VueSDL_update_trails(data, cell_w, cell_h))
+            SDL_RenderCopy(data->renderer, data->trails.texture, NULL, &view.viewport);
+        else
+            VueSDL_view_walls(data, &view);
+    }
+    // or of the cells of the cell layer in the viewport
+    else
+    {
+        // the software path keeps the cells without a texture, the walls are drawn when it failed
+        SDL_Rect cells, rect;
+        VueSDL_visible_cells(&view, width, height, &cells);
+        if (!VueSDL_update_cells(data) || data->cells.texture == NULL)
+            VueSDL_view_walls(data, &view);
+        else if (cells.w > 0 && cells.h > 0)
         {
-        case DIRECTION_UP:
-            VueSDL_box(data, SCOREBOARD_WIDTH + wall->x * cell_w, wall->y * cell_h, cell_w, wall->length * cell_h,
-                       color);
-            break;
-        case DIRECTION_DOWN:
-            VueSDL_box(data, SCOREBOARD_WIDTH + wall->x * cell_w, (wall->y - wall->length + 1) * cell_h, cell_w,
-                       wall->length * cell_h, color);
-            break;
-        case DIRECTION_LEFT:
-            VueSDL_box(data, SCOREBOARD_WIDTH + wall->x * cell_w, wall->y * cell_h, wall->length * cell_w, cell_h,
-                       color);
-            break;
-        case DIRECTION_RIGHT:
-            VueSDL_box(data, SCOREBOARD_WIDTH + (wall->x - wall->length + 1) * cell_w, wall->y * cell_h,
-                       wall->length * cell_w, cell_h, color);
-            break;
+            VueSDL_view_rect(&view, &cells, &rect);
+            SDL_RenderSetClipRect(data->renderer, &view.viewport);
+            SDL_RenderCopy(data->renderer, data->cells.texture, &cells, &rect);
+            SDL_RenderSetClipRect(data->renderer, NULL);
         }
     }
 
-    // player_walls
+    // player_walls, from the heads to the last turns
     Wall wall;
     int distance;
     for (int i = 0; i < player_count; i++)
     {
         Controller_get_player_wall(data->self->game->controller, i, &wall, &distance);
-        SDL_Color color = VueSDL_get_color_value(i);
         Player* player = Controller_get_player(data->self->game->controller, i);
-        switch (player->direction)
-        {
-        case DIRECTION_UP:
-            VueSDL_box(data, SCOREBOARD_WIDTH + player->x * cell_w, player->y * cell_h, cell_w, distance * cell_h,
-                       color);
-            break;
-        case DIRECTION_DOWN:
-            VueSDL_box(data, SCOREBOARD_WIDTH + player->x * cell_w, (player->y - distance + 1) * cell_h, cell_w,
-                       distance * cell_h, color);
-            break;
-        case DIRECTION_LEFT:
-            VueSDL_box(data, SCOREBOARD_WIDTH + player->x * cell_w, player->y * cell_h, distance * cell_w, cell_h,
-                       color);
-            break;
-        case DIRECTION_RIGHT:
-            VueSDL_box(data, SCOREBOARD_WIDTH + (player->x - distance + 1) * cell_w, player->y * cell_h,
-                       distance * cell_w, cell_h, color);
-            break;
-        }
+        const Wall segment = {player->x, player->y, player->direction, distance, i};
+        SDL_Rect cells;
+        VueSDL_wall_cells(&segment, &cells);
+        VueSDL_view_box(data, &view, &cells, VueSDL_get_palette_index(i));
     }
+    VueSDL_flush_boxes(data);
 
-    // players
+    // players, over the walls of the others
     for (int i = 0; i < player_count; i++)
     {
         Player* player = Controller_get_player(data->self->game->controller, i);
-        SDL_Color color = VueSDL_get_color_value(i);
-        VueSDL_box(data, SCOREBOARD_WIDTH + player->x * cell_w, player->y * cell_h, cell_w, cell_h, color);
+        const SDL_Rect cells = {player->x, player->y, 1, 1};
+        VueSDL_view_box(data, &view, &cells, VueSDL_get_palette_index(i));
     }
+    VueSDL_flush_boxes(data);
 }
 
 void VueSDL_play_menu(SDLData* data)
@@ -666,7 +1451,8 @@ void VueSDL_play_menu(SDLData* data)
         if (GAME_STATE_PLAYING == Controller_get_state(data->self->game->controller))
         {
             debug_log("Game started!");
-            *data->start_date = time(NULL);
+            *data->start_date = GameClock_now();
+            VueSDL_reset_camera(data);
         }
         else
         {
@@ -676,12 +1462,15 @@ void VueSDL_play_menu(SDLData* data)
     }
 
     // calculate time since game started
-    time_t crt = *data->start_date;
-    long timer = time(NULL) - crt;
+    long long crt = *data->start_date;
+    long timer = (long)((GameClock_now() - crt) / GAME_CLOCK_SECOND);
 
     if (VueSDL_valid_modal(data))
     {
         // comportment of the page when Pause modal is shown
+        // the pause is not simulated after it, nor the keys pressed during it
+        GameClock_reset(data->game_clock);
+        Controller_clear_moves(data->self->game->controller);
 
         if (state == GAME_STATE_PLAYING)
             VueSDL_render_game(data);
@@ -690,7 +1479,7 @@ void VueSDL_play_menu(SDLData* data)
         {
             // if resume button is clicked, resume the game with timeout
             VueSDL_destroy_modal(data);
-            *data->start_date = time(NULL);
+            *data->start_date = GameClock_now();
         }
         else if (data->modal->button2_clicked)
         {
@@ -705,59 +1494,43 @@ void VueSDL_play_menu(SDLData* data)
     {
         // if game is playing and timeout is over, update the game and render it
 
-        // handle player movements
-        // if the player is alive, move it according to the keys pressed
-        // if two keys in the sense of the player are pressed, the player will continue in the same direction
-        int player_count = Controller_get_player_count(data->self->game->controller);
-        for (int i = 0; i < player_count; i++)
+        // the turns of the players were queued with the key presses, each update applies one turn of a player
+
+        // run the updates due since the last frame, the game keeps its pace whatever the time spent rendering
+        const int steps = GameClock_advance(data->game_clock);
+        for (int i = 0; i < steps && state == GAME_STATE_PLAYING; i++)
         {
-            Player* player = Controller_get_player(data->self->game->controller, i);
-            if (player->state != PLAYER_STATE_ALIVE) continue;
-            int dx = VueSDL_is_key_pressed(data, VueSDL_PLAYER_KEYS[i][VUE_SDL_KEY_RIGHT])
-                - VueSDL_is_key_pressed(data, VueSDL_PLAYER_KEYS[i][VUE_SDL_KEY_LEFT]);
-            int dy = VueSDL_is_key_pressed(data, VueSDL_PLAYER_KEYS[i][VUE_SDL_KEY_DOWN])
-                - VueSDL_is_key_pressed(data, VueSDL_PLAYER_KEYS[i][VUE_SDL_KEY_UP]);
-
-            Direction new_direction;
-            if (dx != 0 && dy == 0)
-                new_direction = dx > 0 ? DIRECTION_RIGHT : DIRECTION_LEFT;
-            else if (dx == 0 && dy != 0)
-                new_direction = dy > 0 ? DIRECTION_DOWN : DIRECTION_UP;
-            else new_direction = player->direction;
-
-            Controller_move_player(data->self->game->controller, i, new_direction);
+            Controller_update(data->self->game->controller);
+            state = Controller_get_state(data->self->game->controller);
         }
 
-
-        // update game state
-        Controller_update(data->self->game->controller);
-        state = Controller_get_state(data->self->game->controller);
-
         // check if game is over
         if (state == GAME_STATE_PLAYING)
         {
             VueSDL_render_game(data);
-            VueSDL_Delay_FPS(GAME_FPS);
+            VueSDL_Delay_FPS(RENDER_FPS);
         }
         else if (state == GAME_STATE_GAME_OVER)
         {
             // if game is over, show game over page with timeout
-            *data->start_date = time(NULL);
+            *data->start_date = GameClock_now();
         }
     }
     else if (state == GAME_STATE_PLAYING)
     {
         // if game is playing and timeout is not over, show countdown
+        GameClock_reset(data->game_clock);
+        Controller_clear_moves(data->self->game->controller);
         VueSDL_render_game(data);
         char msg[100];
         sprintf(msg, "Starting in %ld seconds...", DELAY - timer);
-        VueSDL_label(data, msg, (w + SCOREBOARD_WIDTH) / 2, h / 2, COLOR_COLOR_PRIMARY, VueSDL_FLAG_CENTER);
+        VueSDL_dynamic_label(data, msg, (w + SCOREBOARD_WIDTH) / 2, h / 2, COLOR_COLOR_PRIMARY, VueSDL_FLAG_CENTER);
         VueSDL_Delay_FPS(MENU_FPS);
     }
 
     // recalculate time since game started (for game over page)
     crt = *data->start_date;
-    timer = time(NULL) - crt;
+    timer = (long)((GameClock_now() - crt) / GAME_CLOCK_SECOND);
 
     if (state == GAME_STATE_GAME_OVER && timer > GAME_OVER_DELAY)
     {
@@ -837,10 +1610,18 @@ void VueSDL_clear_keys(SDLData* data)
 
 void VueSDL_handle_key(SDLData* data, SDL_Keycode key)
 {
+    // the directions in the order of the keys of a player
+    static const Direction directions[] = {DIRECTION_UP, DIRECTION_LEFT, DIRECTION_DOWN, DIRECTION_RIGHT};
+    if (key == VUE_SDL_KEY_CAMERA_RESET)
+        VueSDL_reset_camera(data);
     for (int i = 0; i < 4 * MAX_PLAYERS; i++)
         if (data->handler_key[i].key == key)
         {
             data->handler_key[i].pressed = true;
+
+            // queue the turn, the keys pressed within an update are applied at the next ones, in order
+            if (Controller_get_state(data->self->game->controller) == GAME_STATE_PLAYING)
+                Controller_queue_move(data->self->game->controller, i / 4, directions[i % 4]);
             break;
         }
 }
@@ -861,6 +1642,31 @@ void VueSDL_loop(SDLData* data)
                 running = false;
             else if (event.type == SDL_KEYDOWN)
                 VueSDL_handle_key(data, event.key.keysym.sym);
+            else if (event.type == SDL_MOUSEWHEEL && data->menu_state == MENU_STATE_PLAY)
+            {
+                // zoom on the cell under the mouse
+                int mouse_x, mouse_y;
+                SDL_GetMouseState(&mouse_x, &mouse_y);
+                VueSDL_zoom_camera(data, powf(VUE_SDL_ZOOM_STEP, (float)event.wheel.y), mouse_x, mouse_y);
+            }
+            else if (event.type == SDL_MOUSEMOTION && event.motion.state & SDL_BUTTON_RMASK
+                     && data->menu_state == MENU_STATE_PLAY)
+                VueSDL_pan_camera(data, event.motion.xrel, event.motion.yrel);
+            else if (event.type == SDL_RENDER_TARGETS_RESET)
+            {
+                // the content of the target textures was lost
+                VueSDL_clear_labels(data);
+                data->trails.dirty = true;
+            }
+            else if (event.type == SDL_RENDER_DEVICE_RESET)
+            {
+                // the textures were lost with the device
+                VueSDL_destroy_atlas(data);
+                VueSDL_destroy_trails(data);
+                VueSDL_destroy_cells(data);
+                VueSDL_destroy_framebuffer(data);
+                VueSDL_build_atlas(data);
+            }
 
         // clear screen
         SDL_SetRenderDrawColor(data->renderer,
@@ -912,21 +1718,27 @@ int VueSDL_main(Vue* self)
     debug_log("VueSDL_main");
 
     // initialize timer for game
-    time_t* tim = malloc(sizeof(time_t));
+    long long* tim = malloc(sizeof(long long));
     if (tim == NULL)
         return 1;
-    *tim = time(NULL);
+    *tim = GameClock_now();
+
+    // the clock of the updates of the game
+    GameClock game_clock;
+    GameClock_init(&game_clock, GAME_FPS);
 
     SDLData data = {
-        self,
-        tim,
-        NULL,
-        NULL,
-        MENU_STATE_MAIN,
-        NULL,
-        NULL,
-        VUE_SDL_CLICK_UP,
-        NULL
+        .self = self,
+        .start_date = tim,
+        .window = NULL,
+        .renderer = NULL,
+        .menu_state = MENU_STATE_MAIN,
+        .font = NULL,
+        .modal = NULL,
+        .click_state = VUE_SDL_CLICK_UP,
+        .handler_key = NULL,
+        .game_clock = &game_clock,
+        .software = ((VueSDL*)self)->software
     };
 
     // initialize handler keys
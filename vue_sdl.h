@@ -7,6 +7,7 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL.h>
 #include "controller.h"
+#include "game_clock.h"
 #include "vue.h"
 
 #define MENU_FPS 15
@@ -20,6 +21,18 @@
 #define VueSDL_FLAG_TOP 8
 #define VueSDL_FLAG_MIDDLE 16
 #define VueSDL_FLAG_LEFT 32
+#define VUE_SDL_GLYPH_FIRST 32 // first character of the glyph atlas, the space
+#define VUE_SDL_GLYPH_COUNT 95 // characters of the glyph atlas, the printable ASCII
+#define VUE_SDL_LABEL_CACHE 64 // rendered labels kept, the least recently used one is replaced
+#define VUE_SDL_LABEL_LENGTH 64 // longest cached label with its terminator, longer ones are drawn a glyph at a time
+#define VUE_SDL_PALETTE_OTHER MAX_PLAYERS // color of the players without keyboard controls
+#define VUE_SDL_PALETTE_OBSTACLE (MAX_PLAYERS + 1)
+#define VUE_SDL_PALETTE_BACKGROUND (MAX_PLAYERS + 2) // color of the removed walls
+#define VUE_SDL_PALETTE_SIZE (MAX_PLAYERS + 3)
+#define VUE_SDL_MIN_CELL 2 // smallest cell of the trail layer in pixels, the game is drawn from the cell layer below it
+#define VUE_SDL_MAX_ZOOM 64.f
+#define VUE_SDL_ZOOM_STEP 1.25f // zoom of a notch of the mouse wheel
+#define VUE_SDL_KEY_CAMERA_RESET SDLK_HOME // shows the whole game area again
 
 
 typedef enum VueSDL_KeyDirection
@@ -31,10 +44,12 @@ typedef enum VueSDL_KeyDirection
 } VueSDL_KeyDirection;
 
 extern const SDL_Keycode VueSDL_PLAYER_KEYS[MAX_PLAYERS][4];
+extern SDL_Color VueSDL_PALETTE[VUE_SDL_PALETTE_SIZE];
 
 typedef struct VueSDL
 {
     Vue base;
+    bool software; // draws the game on the CPU, for the hosts without a GPU
 } VueSDL;
 
 typedef enum MenuState
@@ -66,6 +81,91 @@ typedef enum VueSDL_ClickState
     VUE_SDL_CLICK_ALREADY_UP
 } VueSDL_ClickState;
 
+// Glyphs of the font rendered once in white, a label copies them and tints them with its color
+typedef struct VueSDL_GlyphAtlas
+{
+    SDL_Texture* texture; // NULL if the atlas could not be built
+    SDL_Rect glyphs[VUE_SDL_GLYPH_COUNT]; // the width of a glyph is its advance
+    int height;
+} VueSDL_GlyphAtlas;
+
+// Label rendered in white from the glyph atlas, tinted with SDL_SetTextureColorMod when it is copied
+typedef struct VueSDL_Label
+{
+    char text[VUE_SDL_LABEL_LENGTH];
+    unsigned int hash;
+    SDL_Texture* texture; // NULL for a free entry
+    int w;
+    int h;
+    unsigned long long last_used;
+} VueSDL_Label;
+
+// Least recently used labels, so that drawing a label again is a single texture copy
+typedef struct VueSDL_LabelCache
+{
+    VueSDL_Label labels[VUE_SDL_LABEL_CACHE];
+    unsigned long long uses;
+} VueSDL_LabelCache;
+
+// Walls and obstacles of the game area, drawn once into a texture and updated with the events of the model
+typedef struct VueSDL_TrailLayer
+{
+    SDL_Texture* texture; // NULL before the first frame of a game, or if the renderer has no target textures
+    int cell_w;
+    int cell_h;
+    int width; // cells of the game area
+    int height;
+    unsigned long long cursor; // next event of the model to draw
+    bool dirty; // cleared and redrawn from the whole model at the next frame, set when the render targets are reset
+} VueSDL_TrailLayer;
+
+// Walls and obstacles of a large game area, a texel per cell in a streaming texture scaled to the viewport
+typedef struct VueSDL_CellLayer
+{
+    SDL_Texture* texture; // NULL before the first frame of a game, or if the game area is too large for a texture
+    Uint32* pixels; // copy of the texture in ARGB8888, the rows one after the other
+    bool* dirty_rows; // rows uploaded to the texture at the next frame
+    int width; // cells of the game area
+    int height;
+    unsigned long long cursor; // next event of the model to draw
+    bool dirty; // redrawn from the whole model at the next frame
+} VueSDL_CellLayer;
+
+// Part of the game area shown in the viewport, moved with the mouse
+typedef struct VueSDL_Camera
+{
+    float zoom; // 1 shows the whole game area
+    float x; // cell at the center of the viewport
+    float y;
+} VueSDL_Camera;
+
+// Mapping of the cells of the game area to the pixels of the window
+typedef struct VueSDL_View
+{
+    SDL_Rect viewport; // pixels of the game area, nothing is drawn outside of it
+    float left; // cell at the left of the viewport
+    float top; // cell at the top of the viewport
+    float scale_x; // pixels of a cell
+    float scale_y;
+} VueSDL_View;
+
+// Game area drawn on the CPU by the software path, presented with a single copy
+typedef struct VueSDL_Framebuffer
+{
+    SDL_Surface* surface; // ARGB8888 pixels of the viewport
+    SDL_Texture* texture; // streaming texture the surface is uploaded to
+    int* columns; // cell of each column of pixels, -1 outside of the game area
+    int* rows; // cell of each row of pixels, -1 outside of the game area
+} VueSDL_Framebuffer;
+
+// Boxes of a color of the palette, drawn with a single call
+typedef struct VueSDL_BoxBatch
+{
+    SDL_Rect* rects;
+    int count;
+    int allocated; // kept from a frame to the next
+} VueSDL_BoxBatch;
+
 typedef struct VueSDK_HandlerKey
 {
     SDL_Keycode key;
@@ -75,7 +175,7 @@ typedef struct VueSDK_HandlerKey
 typedef struct SDLData
 {
     Vue* self;
-    time_t* start_date;
+    long long* start_date; // time of the start of the countdown or of the game over page, from GameClock_now
     SDL_Window* window;
     SDL_Renderer* renderer;
     MenuState menu_state;
@@ -83,6 +183,15 @@ typedef struct SDLData
     VueSDL_Modal* modal;
     int click_state;
     VueSDK_HandlerKey* handler_key;
+    GameClock* game_clock; // updates of the game, at GAME_FPS whatever the time spent rendering
+    VueSDL_GlyphAtlas atlas;
+    VueSDL_LabelCache labels;
+    VueSDL_TrailLayer trails;
+    VueSDL_BoxBatch batches[VUE_SDL_PALETTE_SIZE];
+    VueSDL_CellLayer cells;
+    VueSDL_Camera camera;
+    bool software; // the game area is drawn in the framebuffer, with the SDL software renderer
+    VueSDL_Framebuffer framebuffer;
 } SDLData;
 
 /**
@@ -132,6 +241,274 @@ bool VueSDL_is_clicked(SDLData* data);
  */
 void VueSDL_box(SDLData* data, int x, int y, int w, int h, SDL_Color color);
 
+/**
+ * @brief Mix the colors of the palette
+ */
+void VueSDL_build_palette(void);
+
+/**
+ * @brief Get the color of a player in the palette
+ * @param player The player index
+ * @return The index of the color in the palette
+ */
+int VueSDL_get_palette_index(int player);
+
+/**
+ * @brief Add a box to the batch of its color
+ * @param data The SDL data
+ * @param x The x position
+ * @param y The y position
+ * @param w The width
+ * @param h The height
+ * @param color The index of the color in the palette
+ * @note The box is drawn at the next VueSDL_flush_boxes, the boxes of a color are drawn in order but after or before
+ * the boxes of the other colors
+ */
+void VueSDL_batch_box(SDLData* data, int x, int y, int w, int h, int color);
+
+/**
+ * @brief Draw the pending boxes that a box of a color must cover
+ * @param data The SDL data
+ * @param color The index of the color in the palette
+ * @note The removed walls are erased after the walls drawn before them, and before the walls drawn after them
+ */
+void VueSDL_order_boxes(SDLData* data, int color);
+
+/**
+ * @brief Draw the batches of boxes, a call for each color
+ * @param data The SDL data
+ */
+void VueSDL_flush_boxes(SDLData* data);
+
+/**
+ * @brief Free the batches of boxes
+ * @param data The SDL data
+ */
+void VueSDL_destroy_batches(SDLData* data);
+
+/**
+ * @brief Build the glyph atlas of the font
+ * @param data The SDL data
+ * @return True if the atlas was built, false otherwise (the labels are then rendered by SDL_ttf)
+ */
+bool VueSDL_build_atlas(SDLData* data);
+
+/**
+ * @brief Destroy the glyph atlas and the cached labels
+ * @param data The SDL data
+ */
+void VueSDL_destroy_atlas(SDLData* data);
+
+/**
+ * @brief Destroy the cached labels, they are rendered again when they are drawn
+ * @param data The SDL data
+ * @note Called when the textures of the renderer are lost
+ */
+void VueSDL_clear_labels(SDLData* data);
+
+/**
+ * @brief Get the texture of a label, rendered from the glyph atlas at the first use
+ * @param data The SDL data
+ * @param text The text of the label
+ * @return The label, NULL if it cannot be cached
+ * @note The labels are keyed by their text only, the color and the alignment are applied when they are copied
+ * @note The textures are render targets, the cache is cleared on SDL_RENDER_TARGETS_RESET
+ */
+const VueSDL_Label* VueSDL_get_label(SDLData* data, const char* text);
+
+/**
+ * @brief Get the cells covered by a wall
+ * @param wall The wall
+ * @param cells The output cells
+ */
+void VueSDL_wall_cells(const Wall* wall, SDL_Rect* cells);
+
+/**
+ * @brief Add a wall to the batches of boxes
+ * @param data The SDL data
+ * @param wall The wall
+ * @param x The x position of the game area
+ * @param cell_w The width of a cell
+ * @param cell_h The height of a cell
+ * @param color The index of the color in the palette
+ */
+void VueSDL_draw_wall(SDLData* data, const Wall* wall, int x, int cell_w, int cell_h, int color);
+
+/**
+ * @brief Add the obstacles of the map and the walls of the model to the batches of boxes
+ * @param data The SDL data
+ * @param x The x position of the game area
+ * @param cell_w The width of a cell
+ * @param cell_h The height of a cell
+ */
+void VueSDL_draw_walls(SDLData* data, int x, int cell_w, int cell_h);
+
+/**
+ * @brief Bring the trail layer up to date with the model
+ * @param data The SDL data
+ * @param cell_w The width of a cell
+ * @param cell_h The height of a cell
+ * @return True if the trail layer can be copied, false if the walls must be drawn directly
+ * @note The new, extended and removed walls are drawn from the events of the model, the whole layer is only drawn
+ * again for a new game, a new size of the cells, missed events or a SDL_RENDER_TARGETS_RESET that lost the texture
+ */
+bool VueSDL_update_trails(SDLData* data, int cell_w, int cell_h);
+
+/**
+ * @brief Destroy the texture of the trail layer
+ * @param data The SDL data
+ */
+void VueSDL_destroy_trails(SDLData* data);
+
+/**
+ * @brief Pack a color in a pixel
+ * @param color The color
+ * @return The ARGB8888 pixel
+ */
+Uint32 VueSDL_pack_color(SDL_Color color);
+
+/**
+ * @brief Fill a row of pixels
+ * @param row The first pixel
+ * @param count The number of pixels
+ * @param pixel The pixel
+ * @note 8 pixels at a time with AVX2, 4 with SSE2
+ */
+void VueSDL_fill_row(Uint32* row, int count, Uint32 pixel);
+
+/**
+ * @brief Fill cells of the cell layer
+ * @param layer The cell layer
+ * @param cells The cells, clipped to the game area
+ * @param color The color
+ * @note The rows are marked to upload them at the next frame
+ */
+void VueSDL_fill_cells(VueSDL_CellLayer* layer, const SDL_Rect* cells, SDL_Color color);
+
+/**
+ * @brief Bring the cell layer up to date with the model
+ * @param data The SDL data
+ * @return True if the cell layer can be copied, false if the walls must be drawn directly
+ * @note The walls of the events of the model are filled in the pixels, and only the changed rows are uploaded with
+ * SDL_UpdateTexture
+ */
+bool VueSDL_update_cells(SDLData* data);
+
+/**
+ * @brief Destroy the texture and the pixels of the cell layer
+ * @param data The SDL data
+ */
+void VueSDL_destroy_cells(SDLData* data);
+
+/**
+ * @brief Map pixels to the cells of the game area
+ * @param map The output cell of each pixel, -1 outside of the game area
+ * @param pixels The number of pixels
+ * @param first The cell at the first pixel
+ * @param scale The pixels of a cell
+ * @param cells The number of cells
+ * @note A pixel is in the same cell as with VueSDL_view_rect
+ */
+void VueSDL_map_cells(int* map, int pixels, float first, float scale, int cells);
+
+/**
+ * @brief Draw the game area in the framebuffer and copy it to the window
+ * @param data The SDL data
+ * @param view The view
+ * @return True if the game area was drawn, false if the framebuffer could not be created
+ * @note The rows of the cell layer are drawn by spans of pixels of the same color, and a row of pixels in the same
+ * cells as the one above it is a copy of it
+ */
+bool VueSDL_render_software(SDLData* data, const VueSDL_View* view);
+
+/**
+ * @brief Destroy the framebuffer
+ * @param data The SDL data
+ */
+void VueSDL_destroy_framebuffer(SDLData* data);
+
+/**
+ * @brief Show the whole game area
+ * @param data The SDL data
+ */
+void VueSDL_reset_camera(SDLData* data);
+
+/**
+ * @brief Get the mapping of the cells to the pixels from the camera
+ * @param data The SDL data
+ * @param view The output view
+ */
+void VueSDL_get_view(SDLData* data, VueSDL_View* view);
+
+/**
+ * @brief Zoom the camera, the cell under the mouse stays under it
+ * @param data The SDL data
+ * @param factor The zoom factor, above 1 to zoom in
+ * @param mouse_x The x position of the mouse
+ * @param mouse_y The y position of the mouse
+ */
+void VueSDL_zoom_camera(SDLData* data, float factor, int mouse_x, int mouse_y);
+
+/**
+ * @brief Move the camera with the mouse
+ * @param data The SDL data
+ * @param dx The x motion of the mouse in pixels
+ * @param dy The y motion of the mouse in pixels
+ */
+void VueSDL_pan_camera(SDLData* data, int dx, int dy);
+
+/**
+ * @brief Get the pixels of cells
+ * @param view The view
+ * @param cells The cells
+ * @param rect The output pixels, at least one pixel wide and high
+ */
+void VueSDL_view_rect(const VueSDL_View* view, const SDL_Rect* cells, SDL_Rect* rect);
+
+/**
+ * @brief Get the cells of the game area in the viewport
+ * @param view The view
+ * @param width The width of the game area
+ * @param height The height of the game area
+ * @param cells The output cells
+ */
+void VueSDL_visible_cells(const VueSDL_View* view, int width, int height, SDL_Rect* cells);
+
+/**
+ * @brief Add cells to the batches of boxes, unless they are outside of the viewport
+ * @param data The SDL data
+ * @param view The view
+ * @param cells The cells
+ * @param color The index of the color in the palette
+ */
+void VueSDL_view_box(SDLData* data, const VueSDL_View* view, const SDL_Rect* cells, int color);
+
+/**
+ * @brief Add the obstacles and the walls in the viewport to the batches of boxes
+ * @param data The SDL data
+ * @param view The view
+ */
+void VueSDL_view_walls(SDLData* data, const VueSDL_View* view);
+
+/**
+ * @brief Draw a text a glyph at a time from the glyph atlas
+ * @param data The SDL data
+ * @param text The text
+ * @param x The x position of the top left corner
+ * @param y The y position of the top left corner
+ * @param color The color
+ */
+void VueSDL_draw_glyphs(SDLData* data, const char* text, int x, int y, SDL_Color color);
+
+/**
+ * @brief Get the size of a text drawn from the glyph atlas
+ * @param data The SDL data
+ * @param text The text
+ * @param w The output width
+ * @param h The output height
+ */
+void VueSDL_measure_glyphs(SDLData* data, const char* text, int* w, int* h);
+
 /**
  * @brief Check if a key is pressed
  * @param data The SDL data
@@ -151,6 +528,19 @@ bool VueSDL_is_key_pressed(SDLData* data, SDL_Keycode key);
  */
 void VueSDL_label(SDLData* data, const char* text, int x, int y, SDL_Color color, int flags);
 
+/**
+ * @brief Draw a label whose text changes from one frame to the next
+ * @param data The SDL data
+ * @param text The text
+ * @param x The x position
+ * @param y The y position
+ * @param color The color
+ * @param flags The flags
+ * @note The label is drawn a glyph at a time from the atlas, it is not cached: the cache is kept for the static texts,
+ * that a changing text would evict
+ */
+void VueSDL_dynamic_label(SDLData* data, const char* text, int x, int y, SDL_Color color, int flags);
+
 /**
  * @brief Draw a slider
  * @param data The SDL data